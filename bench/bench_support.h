@@ -0,0 +1,31 @@
+// Helpers shared by the database benches
+#pragma once
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+inline double Percentile(const std::vector<double> &sorted, double p)
+{
+    size_t index = static_cast<size_t>(p * sorted.size());
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// First column of every row of a query, e.g. all recipe numbers
+inline std::vector<std::string> LoadKeys(const std::string &dbPath, const char *sql)
+{
+    std::vector<std::string> keys;
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK)
+    {
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+            keys.emplace_back(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return keys;
+}
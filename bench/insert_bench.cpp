@@ -0,0 +1,244 @@
+// RecipeLine insert throughput: the old per-row SQL text path against the
+// prepared statement path, on the same generated rows
+//
+// Usage: InsertBench [rows] [db-path]   (default: 1000000 rows, a file in the temp folder)
+//
+// Both passes run under the bulk-load profile in one transaction on a freshly
+// created table, so only the way rows reach SQLite differs.
+
+#include "number_parse.h"
+#include "sqlite_insert.h"
+#include "sqlite_session.h"
+#include "table_schema.h"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using Schema = RecipeLineSchema;
+    constexpr size_t kColumnCount = Schema::kColumns.size();
+
+    // Deterministic cells shaped like the export: 10 lines per recipe, 20000
+    // materials, some empty cells and the odd apostrophe
+    void GenerateRow(size_t row, std::vector<std::string> &cells)
+    {
+        for (size_t column = 0; column < kColumnCount; column++)
+        {
+            std::string &cell = cells[column];
+            const ColumnDesc &desc = Schema::kColumns[column];
+            size_t mix = row * 31 + column * 7;
+            if (column == 0)
+                cell = "R" + std::to_string(100000 + row / 10);
+            else if (column == 1)
+                cell = std::to_string(row % 10 + 1);
+            else if (column == 3)
+                cell = "M" + std::to_string(10000 + row % 20000);
+            else if (mix % 5 == 0)
+                cell.clear();
+            else if (desc.value.type == SqlType::Text)
+                cell = mix % 17 == 0 ? "Baker's tip " + std::to_string(mix % 1000) : "T" + std::to_string(mix % 100000);
+            else if (desc.value.type == SqlType::Real)
+                cell = std::to_string(mix % 1000) + "," + std::to_string(mix % 100);
+            else
+                cell = std::to_string(mix % 500);
+        }
+    }
+
+    // The pre-prepared-statement path: quote and escape every value into one
+    // INSERT statement and run it with sqlite3_exec
+    std::string SqlValue(const std::string &cell, const ColumnDesc &desc)
+    {
+        if (cell.empty())
+        {
+            if (desc.value.type == SqlType::Text)
+                return "'" + std::string(desc.value.text) + "'";
+            if (desc.value.type == SqlType::Real)
+                return std::to_string(desc.value.real);
+            return std::to_string(desc.value.integer);
+        }
+        if (desc.value.type != SqlType::Text)
+        {
+            // The CSV decimal comma has to become a point in SQL text
+            std::string number = cell;
+            for (char &c : number)
+                if (c == ',')
+                    c = '.';
+            return number;
+        }
+        std::string escaped = "'";
+        for (char c : cell)
+        {
+            if (c == '\'')
+                escaped += '\'';
+            escaped += c;
+        }
+        return escaped + "'";
+    }
+
+    bool InsertBySqlText(sqlite3 *db, size_t rows, std::string &error)
+    {
+        std::vector<std::string> cells(kColumnCount);
+        std::string sql;
+        for (size_t row = 0; row < rows; row++)
+        {
+            GenerateRow(row, cells);
+            sql = "INSERT OR REPLACE INTO RecipeLine VALUES (";
+            for (size_t column = 0; column < kColumnCount; column++)
+            {
+                if (column)
+                    sql += ',';
+                sql += SqlValue(cells[column], Schema::kColumns[column]);
+            }
+            sql += ");";
+
+            char *message = nullptr;
+            if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) != SQLITE_OK)
+            {
+                error = message ? message : sqlite3_errmsg(db);
+                sqlite3_free(message);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The importer's path: one prepared statement, values bound by column type
+    bool InsertByPreparedStatement(sqlite3 *db, size_t rows, std::string &error)
+    {
+        PreparedInsert insert;
+        if (!insert.Prepare(db, Schema::kName, kColumnCount))
+        {
+            error = sqlite3_errmsg(db);
+            return false;
+        }
+
+        std::vector<std::string> cells(kColumnCount);
+        for (size_t row = 0; row < rows; row++)
+        {
+            GenerateRow(row, cells);
+            for (size_t column = 0; column < kColumnCount; column++)
+            {
+                const std::string &cell = cells[column];
+                const TypedDefault &value = Schema::kColumns[column].value;
+                bool bound = true;
+                if (value.type == SqlType::Text)
+                {
+                    bound = insert.BindText(column, cell.empty() ? std::string_view(value.text) : cell);
+                }
+                else if (value.type == SqlType::Real)
+                {
+                    double number = value.real;
+                    bound = (cell.empty() || ParseDecimal(cell, number)) && insert.BindReal(column, number);
+                }
+                else
+                {
+                    long long number = value.integer;
+                    bound = (cell.empty() || ParseInteger(cell, number)) && insert.BindInteger(column, number);
+                }
+                if (!bound)
+                {
+                    error = "cannot bind row " + std::to_string(row) + " column " + std::to_string(column);
+                    return false;
+                }
+            }
+            if (!insert.Execute())
+            {
+                error = insert.ErrorMessage();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Exec(sqlite3 *db, const std::string &sql, std::string &error)
+    {
+        char *message = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &message) == SQLITE_OK)
+            return true;
+        error = message ? message : sqlite3_errmsg(db);
+        sqlite3_free(message);
+        return false;
+    }
+
+    // Times one pass on an empty table; returns rows per second, or 0 on failure
+    double RunPass(sqlite3 *db, size_t rows, bool (*insert)(sqlite3 *, size_t, std::string &), std::string &error)
+    {
+        if (!Exec(db, "DROP TABLE IF EXISTS RecipeLine;", error) || !Exec(db, CreateTableSql<Schema>(), error))
+            return 0;
+
+        auto started = std::chrono::steady_clock::now();
+        if (!Exec(db, "BEGIN;", error))
+            return 0;
+        if (!insert(db, rows, error))
+        {
+            Exec(db, "ROLLBACK;", error);
+            return 0;
+        }
+        if (!Exec(db, "COMMIT;", error))
+            return 0;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return static_cast<double>(rows) / seconds;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::filesystem::path dbPath =
+        argc > 2 ? std::filesystem::path(argv[2]) : std::filesystem::temp_directory_path() / "bakery_insert_bench.db";
+    if (rows == 0)
+    {
+        std::fprintf(stderr, "Usage: %s [rows] [db-path]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove(dbPath, ignored);
+    sqlite3 *db = nullptr;
+    if (sqlite3_open(dbPath.string().c_str(), &db) != SQLITE_OK)
+    {
+        std::fprintf(stderr, "Cannot open %s: %s\n", dbPath.string().c_str(), sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return EXIT_FAILURE;
+    }
+
+    SessionSettings session;
+    std::string error;
+    if (!session.Apply(db, SessionProfile::BulkLoad, error))
+    {
+        std::fprintf(stderr, "Cannot apply the bulk-load profile: %s\n", error.c_str());
+        sqlite3_close(db);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%zu RecipeLine rows into %s (bulk-load profile, one transaction)\n", rows, dbPath.string().c_str());
+    const std::pair<const char *, bool (*)(sqlite3 *, size_t, std::string &)> passes[] = {
+        {"SQL text + sqlite3_exec", InsertBySqlText}, {"prepared statement", InsertByPreparedStatement}};
+    double rates[2] = {};
+    int status = EXIT_SUCCESS;
+    for (size_t i = 0; i < 2; i++)
+    {
+        rates[i] = RunPass(db, rows, passes[i].second, error);
+        if (rates[i] == 0)
+        {
+            std::fprintf(stderr, "%s failed: %s\n", passes[i].first, error.c_str());
+            status = EXIT_FAILURE;
+            break;
+        }
+        std::printf("  %-24s %10.0f rows/s\n", passes[i].first, rates[i]);
+    }
+    if (status == EXIT_SUCCESS)
+        std::printf("  speedup                  %10.2fx\n", rates[1] / rates[0]);
+
+    session.Restore();
+    sqlite3_close(db);
+    std::filesystem::remove(dbPath, ignored);
+    return status;
+}
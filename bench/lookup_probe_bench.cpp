@@ -0,0 +1,90 @@
+// Latency of the lookups an application makes against the imported tables,
+// to compare table layouts and indexes
+//
+// Usage: LookupProbeBench <db-path> [count]   (default: 10000 lookups of each kind)
+
+#include "bench_support.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Times up to 'count' runs of a query with one key parameter, picking keys
+    // at random; stops early after 10 s so that a scan does not run for hours
+    bool ProbeQuery(sqlite3 *db, const char *label, const char *sql, const std::vector<std::string> &keys,
+                    size_t count)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::fprintf(stderr, "Cannot prepare %s: %s\n", label, sqlite3_errmsg(db));
+            return false;
+        }
+
+        std::mt19937 random(12345);
+        std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+        std::vector<double> latencies;
+        latencies.reserve(count);
+        size_t rows = 0;
+        auto probeStarted = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count && std::chrono::steady_clock::now() - probeStarted < std::chrono::seconds(10);
+             i++)
+        {
+            const std::string &key = keys[pick(random)];
+            auto started = std::chrono::steady_clock::now();
+            sqlite3_bind_text(stmt, 1, key.data(), static_cast<int>(key.size()), SQLITE_STATIC);
+            while (sqlite3_step(stmt) == SQLITE_ROW)
+                rows++;
+            sqlite3_reset(stmt);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+            latencies.push_back(elapsed.count());
+        }
+        sqlite3_finalize(stmt);
+
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("  %-14s p50 %.3f  p90 %.3f  p99 %.3f  max %.3f ms  (%zu lookups, %.1f rows each)\n", label,
+                    Percentile(latencies, 0.50) * 1e3, Percentile(latencies, 0.90) * 1e3,
+                    Percentile(latencies, 0.99) * 1e3, latencies.back() * 1e3, latencies.size(),
+                    static_cast<double>(rows) / latencies.size());
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+    if (argc < 2 || argc > 3 || count == 0)
+    {
+        std::fprintf(stderr, "Usage: %s <db-path> [count]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string dbPath = argv[1];
+    std::vector<std::string> recipes = LoadKeys(dbPath, "SELECT Nr FROM RecipeHead");
+    std::vector<std::string> materials = LoadKeys(dbPath, "SELECT MatItemNr FROM Matlist");
+    sqlite3 *db = nullptr;
+    if (recipes.empty() || materials.empty() ||
+        sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+    {
+        std::fprintf(stderr, "No recipes or materials in %s; import once with the CLI first\n", dbPath.c_str());
+        sqlite3_close(db);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Lookup probe: up to %zu lookups each, latency in ms\n", count);
+    bool ok = ProbeQuery(db, "material", "SELECT * FROM Matlist WHERE MatItemNr = ?", materials, count) &&
+              ProbeQuery(db, "recipe lines", "SELECT * FROM RecipeLine WHERE RcpNr = ? ORDER BY RcpLine", recipes,
+                         count) &&
+              ProbeQuery(db, "where-used", "SELECT DISTINCT RcpNr FROM RecipeLine WHERE MatItemNr = ?", materials,
+                         count);
+    sqlite3_close(db);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
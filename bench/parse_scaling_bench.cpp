@@ -0,0 +1,97 @@
+// Parse-only throughput of the three CSV files with 1 to 16 parser threads;
+// no database is touched
+//
+// Usage: ParseScalingBench <csv-folder>
+
+#include "csv_reader.h"
+#include "importer.h"
+#include "table_schema.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // Parses one file to the end and returns the seconds taken, or a negative value on error
+    double TimeParse(TableColumns columns, const std::string &filename, const ImportOptions &options,
+                     size_t threads, size_t &rows)
+    {
+        auto started = std::chrono::steady_clock::now();
+        CsvBatchReader reader(columns, options.batchRows, options.queueDepth, threads);
+        if (!reader.Start(filename))
+        {
+            std::fprintf(stderr, "Cannot open %s: %s\n", filename.c_str(), reader.Error().c_str());
+            return -1.0;
+        }
+        RowBatchPtr batch;
+        while (reader.Next(batch))
+        {
+        }
+        if (reader.Failed())
+        {
+            std::fprintf(stderr, "Cannot parse %s: %s\n", filename.c_str(), reader.Error().c_str());
+            return -1.0;
+        }
+        rows = reader.RowsRead();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        return elapsed.count();
+    }
+
+    // Parse-only throughput for 1, 2, 4, 8 and 16 threads, best of three runs each
+    bool MeasureParseScaling(TableColumns columns, const std::string &filename, const ImportOptions &options)
+    {
+        std::error_code ec;
+        double megabytes = std::filesystem::file_size(filename, ec) / 1e6;
+        if (ec)
+        {
+            std::fprintf(stderr, "Cannot open %s: %s\n", filename.c_str(), ec.message().c_str());
+            return false;
+        }
+
+        std::printf("Parse scaling: %s (%.1f MB, %u hardware threads)\n", filename.c_str(), megabytes,
+                    std::thread::hardware_concurrency());
+        std::printf("  threads   seconds      MB/s   speedup\n");
+
+        double baseline = 0.0;
+        for (size_t threads = 1; threads <= 16; threads *= 2)
+        {
+            double best = -1.0;
+            size_t rows = 0;
+            for (int run = 0; run < 3; run++)
+            {
+                double seconds = TimeParse(columns, filename, options, threads, rows);
+                if (seconds < 0)
+                    return false;
+                if (best < 0 || seconds < best)
+                    best = seconds;
+            }
+            if (threads == 1)
+                baseline = best;
+            std::printf("  %7zu %9.3f %9.1f %8.2fx  (%zu rows)\n", threads, best, megabytes / best,
+                        baseline / best, rows);
+            std::fflush(stdout);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "Usage: %s <csv-folder>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The import's own batch and queue sizes
+    ImportOptions options;
+    std::filesystem::path folder(argv[1]);
+    bool ok = MeasureParseScaling(ColumnsOf<MatlistSchema>(), (folder / "Matlist.csv").string(), options) &&
+              MeasureParseScaling(ColumnsOf<RecipeHeadSchema>(), (folder / "Recipehead.csv").string(), options) &&
+              MeasureParseScaling(ColumnsOf<RecipeLineSchema>(), (folder / "Recipeline.csv").string(), options);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
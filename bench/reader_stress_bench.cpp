@@ -0,0 +1,172 @@
+// Reader latency while an import writes: mixer-terminal stand-in threads look
+// up random recipes in the database during a forced import of the CSV files
+//
+// Usage: ReaderStressBench <csv-folder> <db-path> [readers] [profile]   (default: 4 readers, online)
+//
+// The database must already hold recipes, so import once with the CLI first.
+
+#include "bench_support.h"
+#include "import_progress.h"
+#include "importer.h"
+#include "log_sink.h"
+#include "staging_database.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Threads that look up a random recipe with its lines and material names,
+    // pausing 1 ms between queries, and time each query
+    class ReaderStress
+    {
+    public:
+        bool Start(const std::string &dbPath, size_t readers)
+        {
+            m_recipes = LoadKeys(dbPath, "SELECT Nr FROM RecipeHead");
+            if (m_recipes.empty())
+            {
+                std::fprintf(stderr, "No recipes in %s; import once with the CLI first\n", dbPath.c_str());
+                return false;
+            }
+
+            // Keeps a staging import from renaming over the database while the readers have it open
+            std::string lockError;
+            if (!m_readerLock.Acquire(dbPath, lockError))
+            {
+                std::fprintf(stderr, "%s\n", lockError.c_str());
+                return false;
+            }
+
+            m_latencies.resize(readers);
+            m_errors.resize(readers);
+            for (size_t i = 0; i < readers; i++)
+                m_threads.emplace_back([this, dbPath, i] { Run(dbPath, i); });
+            return true;
+        }
+
+        // Returns false if any query failed
+        bool StopAndPrint()
+        {
+            m_stop.store(true);
+            for (std::thread &thread : m_threads)
+                thread.join();
+            m_readerLock.Release();
+
+            std::vector<double> all;
+            size_t errors = 0;
+            for (size_t i = 0; i < m_threads.size(); i++)
+            {
+                all.insert(all.end(), m_latencies[i].begin(), m_latencies[i].end());
+                errors += m_errors[i];
+            }
+            std::sort(all.begin(), all.end());
+            size_t slow = all.end() - std::lower_bound(all.begin(), all.end(), 0.1);
+
+            std::printf("Reader stress: %zu readers, %zu queries, %zu errors, %zu over 100 ms\n", m_threads.size(),
+                        all.size(), errors, slow);
+            if (!all.empty())
+            {
+                std::printf("  latency ms: p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n",
+                            Percentile(all, 0.50) * 1e3, Percentile(all, 0.90) * 1e3, Percentile(all, 0.99) * 1e3,
+                            Percentile(all, 0.999) * 1e3, all.back() * 1e3);
+            }
+            return errors == 0;
+        }
+
+    private:
+        void Run(const std::string &dbPath, size_t reader)
+        {
+            sqlite3 *db = nullptr;
+            sqlite3_stmt *stmt = nullptr;
+            // The timeout is set before preparing, which can meet the import switching the journal to WAL
+            if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+                sqlite3_busy_timeout(db, 10000) != SQLITE_OK ||
+                sqlite3_prepare_v2(db,
+                                   "SELECT l.RcpLine, l.MatItemNr, l.SetWeight, m.Name FROM RecipeLine l "
+                                   "LEFT JOIN Matlist m ON m.MatItemNr = l.MatItemNr WHERE l.RcpNr = ?",
+                                   -1, &stmt, nullptr) != SQLITE_OK)
+            {
+                m_errors[reader]++;
+                sqlite3_close(db);
+                return;
+            }
+
+            std::mt19937 random(static_cast<unsigned>(reader) * 7919u + 1u);
+            std::uniform_int_distribution<size_t> pick(0, m_recipes.size() - 1);
+            while (!m_stop.load())
+            {
+                const std::string &recipe = m_recipes[pick(random)];
+                auto started = std::chrono::steady_clock::now();
+                sqlite3_bind_text(stmt, 1, recipe.data(), static_cast<int>(recipe.size()), SQLITE_STATIC);
+                int rc;
+                while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+                {
+                }
+                sqlite3_reset(stmt);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+                if (rc == SQLITE_DONE)
+                    m_latencies[reader].push_back(elapsed.count());
+                else
+                    m_errors[reader]++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            sqlite3_finalize(stmt);
+            sqlite3_close(db);
+        }
+
+        std::vector<std::string> m_recipes;
+        std::vector<std::thread> m_threads;
+        std::vector<std::vector<double>> m_latencies; // seconds, per reader
+        std::vector<size_t> m_errors;
+        std::atomic<bool> m_stop{false};
+        StagingReaderLock m_readerLock;
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    ImportOptions options;
+    options.profile = SessionProfile::Online;
+    options.forceImport = true;
+    size_t readers = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+    if (argc < 3 || argc > 5 || readers == 0 || (argc > 4 && !ParseSessionProfile(argv[4], options.profile)))
+    {
+        std::fprintf(stderr, "Usage: %s <csv-folder> <db-path> [readers] [bulk-load|safe|staging|online]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *profileName = argc > 4 ? argv[4] : "online";
+    options.csvFolder = argv[1];
+    options.dbPath = argv[2];
+
+    ReaderStress stress;
+    if (!stress.Start(options.dbPath, readers))
+        return EXIT_FAILURE;
+
+    auto started = std::chrono::steady_clock::now();
+    ImportProgress progress;
+    ImportReport report;
+    bool success = RunImport(options, progress, report);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    bool readersOk = stress.StopAndPrint();
+
+    // Only errors from the import log; the rest would drown the latencies
+    std::vector<LogRecord> log;
+    AppLog().Drain(log);
+    for (const LogRecord &record : log)
+    {
+        if (record.text.compare(0, 6, "ERROR:") == 0)
+            std::fprintf(stderr, "%s\n", record.text.c_str());
+    }
+    std::printf("Import (%s profile): %s in %.2f s\n", profileName, success ? "done" : "failed", seconds);
+    return success && readersOk ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+// Latin-1 to UTF-8 throughput per kernel on generated text, against the
+// original per-line conversion of the import as the baseline
+//
+// Usage: TranscodeBench [size-mb] [high-byte-percent]   (default: 64 MiB, 2%)
+
+#include "simd_support.h"
+#include "transcode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Average Recipeline.csv line length, including the line break
+    constexpr size_t kLineBytes = 160;
+
+    // The import's conversion before the kernels, unchanged: one new string per line
+    std::string ConvertISO88591ToUTF8(const std::string &iso_string)
+    {
+        std::string utf8_string;
+        utf8_string.reserve(iso_string.size() * 2);
+
+        for (unsigned char c : iso_string)
+        {
+            if (c < 0x80)
+            {
+                utf8_string += static_cast<char>(c);
+            }
+            else
+            {
+                utf8_string += static_cast<char>(0xC0 | (c >> 6));
+                utf8_string += static_cast<char>(0x80 | (c & 0x3F));
+            }
+        }
+        return utf8_string;
+    }
+
+    // Converts the text one line-sized piece at a time, as the getline loop did,
+    // and copies each result to 'out' so that the output can be compared
+    size_t ConvertByLine(const std::string &text, char *out)
+    {
+        std::string line;
+        size_t written = 0;
+        for (size_t offset = 0; offset < text.size(); offset += kLineBytes)
+        {
+            line.assign(text, offset, kLineBytes);
+            std::string utf8Line = ConvertISO88591ToUTF8(line);
+            std::memcpy(out + written, utf8Line.data(), utf8Line.size());
+            written += utf8Line.size();
+        }
+        return written;
+    }
+
+    // Best of five passes, in seconds
+    template <typename Convert>
+    double BestOfFive(Convert convert, size_t &written)
+    {
+        double best = 0;
+        for (int pass = 0; pass < 5; pass++)
+        {
+            auto started = std::chrono::steady_clock::now();
+            written = convert();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            if (pass == 0 || seconds < best)
+                best = seconds;
+        }
+        return best;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t sizeMb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    unsigned highPercent = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 2;
+    if (sizeMb == 0 || highPercent > 100)
+    {
+        std::fprintf(stderr, "Usage: %s [size-mb] [high-byte-percent]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Text shaped like the exports: ASCII with the odd umlaut, fixed seed
+    std::mt19937 random(42);
+    std::string text(sizeMb << 20, '\0');
+    const char umlauts[] = "\xE4\xF6\xFC\xDF\xC4";
+    for (char &c : text)
+        c = random() % 100 < highPercent ? umlauts[random() % 5] : static_cast<char>(' ' + random() % 90);
+    std::vector<char> expected(Latin1ToUtf8MaxSize(text.size()));
+    std::vector<char> out(expected.size());
+
+    std::printf("%zu MiB, %u%% high bytes\n", sizeMb, highPercent);
+    size_t expectedSize = 0;
+    double baseline = BestOfFive([&] { return ConvertByLine(text, expected.data()); }, expectedSize);
+    std::printf("  %-14s %8.0f MiB/s %7.2fx (%zu bytes out, %zu-byte lines)\n", "original",
+                static_cast<double>(sizeMb) / baseline, 1.0, expectedSize, kLineBytes);
+
+    const std::pair<SimdLevel, const char *> levels[] = {
+        {SimdLevel::Scalar, "scalar"}, {SimdLevel::Sse2, "SSE2"}, {SimdLevel::Avx2, "AVX2 (pshufb)"}};
+    int status = EXIT_SUCCESS;
+    for (const auto &[level, name] : levels)
+    {
+        if (level > DetectSimdLevel())
+        {
+            std::printf("  %-14s not supported by this CPU\n", name);
+            continue;
+        }
+
+        size_t written = 0;
+        SimdLevel kernel = level;
+        double best = BestOfFive(
+            [&] { return TranscodeLatin1ToUtf8(text.data(), text.size(), out.data(), kernel); }, written);
+        bool same = written == expectedSize && std::equal(out.begin(), out.begin() + written, expected.begin());
+        std::printf("  %-14s %8.0f MiB/s %7.2fx (%zu bytes out)%s\n", name, static_cast<double>(sizeMb) / best,
+                    baseline / best, written, same ? "" : "  OUTPUT DIFFERS FROM THE ORIGINAL");
+        if (!same)
+            status = EXIT_FAILURE;
+    }
+    return status;
+}
@@ -0,0 +1,55 @@
+#include "alloc_counter.h"
+
+#ifdef BAKERY_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocations{0};
+}
+
+// The array, nothrow and sized forms of the standard library forward to these
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+bool AllocationCountingEnabled()
+{
+    return true;
+}
+
+uint64_t AllocationCount()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCountingEnabled()
+{
+    return false;
+}
+
+uint64_t AllocationCount()
+{
+    return 0;
+}
+
+#endif
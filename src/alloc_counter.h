@@ -0,0 +1,10 @@
+// Debug count of global operator new calls. Built in only when the core is
+// compiled with BAKERY_COUNT_ALLOCATIONS; otherwise the count stays at zero.
+#pragma once
+
+#include <cstdint>
+
+bool AllocationCountingEnabled();
+
+// Calls to the global operator new so far, from every thread
+uint64_t AllocationCount();
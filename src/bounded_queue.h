@@ -0,0 +1,66 @@
+// Blocking single-producer/single-consumer hand-off with a fixed capacity
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    // Blocks while full; returns false if the consumer cancelled
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_cancelled || m_items.size() < m_capacity; });
+        if (m_cancelled)
+            return false;
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks until an item arrives; returns false once closed and drained
+    bool Pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_cancelled || m_closed || !m_items.empty(); });
+        if (m_cancelled || m_items.empty())
+            return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // Producer is done; Pop drains what is left and then returns false
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+
+    // Consumer gave up; wakes and fails both sides
+    void Cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+        m_items.clear();
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed = false;
+    bool m_cancelled = false;
+};
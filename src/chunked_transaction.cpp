@@ -0,0 +1,64 @@
+#include "chunked_transaction.h"
+
+namespace
+{
+    // Reading the clock every row costs more than the check is worth
+    constexpr size_t kClockInterval = 256;
+
+    bool Exec(sqlite3 *db, const char *sql, std::string &error)
+    {
+        char *errMsg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) == SQLITE_OK)
+            return true;
+        error = std::string(sql) + ": " + (errMsg ? errMsg : "Unknown");
+        sqlite3_free(errMsg);
+        return false;
+    }
+}
+
+ChunkedTransaction::ChunkedTransaction(sqlite3 *db, size_t maxRows, double maxSeconds, bool checkpoint)
+    : m_db(db), m_maxRows(maxRows), m_maxSeconds(maxSeconds), m_checkpoint(checkpoint)
+{
+}
+
+bool ChunkedTransaction::Begin(std::string &error)
+{
+    m_rows = 0;
+    m_started = std::chrono::steady_clock::now();
+    return Exec(m_db, "BEGIN TRANSACTION", error);
+}
+
+bool ChunkedTransaction::RowDone(std::string &error)
+{
+    m_rows++;
+    bool full = m_maxRows != 0 && m_rows >= m_maxRows;
+    if (!full && m_maxSeconds > 0.0 && m_rows % kClockInterval == 0)
+    {
+        std::chrono::duration<double> open = std::chrono::steady_clock::now() - m_started;
+        full = open.count() >= m_maxSeconds;
+    }
+    return !full || (Commit(error) && Begin(error));
+}
+
+bool ChunkedTransaction::Commit(std::string &error)
+{
+    if (m_hook && !m_hook(error))
+        return false;
+    if (!Exec(m_db, "COMMIT", error))
+        return false;
+
+    std::chrono::duration<double> held = std::chrono::steady_clock::now() - m_started;
+    if (held.count() > m_longest)
+        m_longest = held.count();
+    m_commits++;
+
+    if (m_checkpoint &&
+        sqlite3_wal_checkpoint_v2(m_db, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr) == SQLITE_OK)
+        m_checkpoints++;
+    return true;
+}
+
+void ChunkedTransaction::Rollback()
+{
+    sqlite3_exec(m_db, "ROLLBACK", nullptr, nullptr, nullptr);
+}
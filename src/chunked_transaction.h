@@ -0,0 +1,49 @@
+// A write transaction that commits in bounded chunks
+#pragma once
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+
+// Commits and begins anew every 'maxRows' rows or 'maxSeconds', whichever
+// comes first; zero disables that limit, so with both zero the whole table is
+// one transaction. Each commit can be followed by a PASSIVE checkpoint, which
+// copies what it can from the WAL without waiting for or blocking readers.
+class ChunkedTransaction
+{
+public:
+    // Writes inside the transaction just before it commits
+    using CommitHook = std::function<bool(std::string &error)>;
+
+    ChunkedTransaction(sqlite3 *db, size_t maxRows, double maxSeconds, bool checkpoint);
+
+    // Runs before every COMMIT, so what it writes is durable with the chunk's rows
+    void SetCommitHook(CommitHook hook) { m_hook = std::move(hook); }
+
+    bool Begin(std::string &error);
+    // Call once per row; commits the chunk when a limit is reached
+    bool RowDone(std::string &error);
+    bool Commit(std::string &error);
+    void Rollback();
+
+    size_t Commits() const { return m_commits; }
+    size_t Checkpoints() const { return m_checkpoints; }
+    double LongestSeconds() const { return m_longest; } // longest time the write lock was held
+
+private:
+    sqlite3 *m_db;
+    size_t m_maxRows;
+    double m_maxSeconds;
+    bool m_checkpoint;
+    CommitHook m_hook;
+
+    std::chrono::steady_clock::time_point m_started;
+    size_t m_rows = 0;
+    size_t m_commits = 0;
+    size_t m_checkpoints = 0;
+    double m_longest = 0.0;
+};
@@ -0,0 +1,286 @@
+// Headless Bakery CSV import: same import as the window, driven from the command line
+
+#include "import_progress.h"
+#include "importer.h"
+#include "log_sink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void PrintUsage(const char *program)
+    {
+        std::printf("Usage: %s <csv-folder> [db-path] [options]\n"
+                    "\n"
+                    "Imports Matlist.csv, Recipehead.csv and Recipeline.csv into a SQLite database\n"
+                    "(default db-path: bakery.db).\n"
+                    "\n"
+                    "Options:\n"
+                    "  --profile <bulk-load|safe|staging|online>\n"
+                    "                              SQLite session profile (default: bulk-load);\n"
+                    "                              staging builds <db-path>.staging and swaps it in,\n"
+                    "                              online writes through WAL in short transactions\n"
+                    "  --commit-rows <n>           commit every n rows (default: online 20000,\n"
+                    "                              otherwise once per table)\n"
+                    "  --commit-ms <n>             commit at least every n milliseconds\n"
+                    "                              (default: online 250)\n"
+                    "  --resume                    continue files whose last import was interrupted\n"
+                    "                              after their last committed chunk (commits every\n"
+                    "                              100000 rows or 5 s unless set; crash-safe with\n"
+                    "                              the safe and online profiles)\n"
+                    "  --threads <n>               parser threads per file (default or 0: one per core)\n"
+                    "  --delta                     write only new and changed rows and delete rows\n"
+                    "                              missing from the CSV, using stored row hashes\n"
+                    "  --force                     import every file, even those unchanged since\n"
+                    "                              the last import\n"
+                    "  --layout <rowid|without-rowid>\n"
+                    "                              how new Matlist and RecipeLine tables store rows\n"
+                    "                              (default: rowid)\n"
+                    "  --indexes                   build secondary indexes (RecipeLine by MatItemNr)\n"
+                    "                              after the load and run ANALYZE\n"
+                    "  --sort                      insert each table in primary key order\n"
+                    "  --sort-memory-mb <n>        parsed rows kept in memory per table before\n"
+                    "                              sorted runs go to disk (default: 256)\n"
+                    "  --foreign-keys <off|report|reject>\n"
+                    "                              check Recipeline keys against Matlist and\n"
+                    "                              Recipehead; reject skips orphan lines (default: report)\n"
+                    "  --orphans <file>            write every orphan line to a ';' separated file\n"
+                    "  --quarantine                keep going past rows that do not parse, are\n"
+                    "                              refused by the database or are rejected orphans;\n"
+                    "                              they go to the ImportRejects table (not with\n"
+                    "                              the staging profile)\n"
+                    "  --log <file>                also append the log to a file\n"
+                    "  --quiet                     print only errors and the run report\n"
+                    "  --help                      show this text\n",
+                    program);
+    }
+
+    struct CliOptions
+    {
+        ImportOptions import;
+        std::string logPath;
+        bool quiet = false;
+    };
+
+    // Returns false on bad arguments; 'exitCode' says whether that was --help
+    bool ParseArguments(int argc, char **argv, CliOptions &cli, int &exitCode)
+    {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h")
+            {
+                PrintUsage(argv[0]);
+                exitCode = 0;
+                return false;
+            }
+            else if (arg == "--quiet" || arg == "-q")
+            {
+                cli.quiet = true;
+            }
+            else if (arg == "--delta")
+            {
+                cli.import.mode = ImportMode::Delta;
+            }
+            else if (arg == "--force")
+            {
+                cli.import.forceImport = true;
+            }
+            else if (arg == "--indexes")
+            {
+                cli.import.secondaryIndexes = true;
+            }
+            else if (arg == "--sort")
+            {
+                cli.import.sortByKey = true;
+            }
+            else if (arg == "--resume")
+            {
+                cli.import.resume = true;
+            }
+            else if (arg == "--quarantine")
+            {
+                cli.import.quarantine = true;
+            }
+            else if ((arg == "--profile" || arg == "--log" || arg == "--threads" || arg == "--foreign-keys" ||
+                      arg == "--orphans" || arg == "--commit-rows" || arg == "--commit-ms" ||
+                      arg == "--sort-memory-mb" || arg == "--layout") &&
+                     i + 1 < argc)
+            {
+                std::string value = argv[++i];
+                if (arg == "--log")
+                {
+                    cli.logPath = value;
+                }
+                else if (arg == "--orphans")
+                {
+                    cli.import.orphanReportPath = value;
+                }
+                else if (arg == "--layout")
+                {
+                    if (!ParseTableLayout(value, cli.import.layout))
+                    {
+                        std::fprintf(stderr, "Unknown table layout: %s\n", value.c_str());
+                        exitCode = 2;
+                        return false;
+                    }
+                }
+                else if (arg == "--foreign-keys")
+                {
+                    if (!ParseForeignKeyMode(value, cli.import.foreignKeys))
+                    {
+                        std::fprintf(stderr, "Unknown foreign key mode: %s\n", value.c_str());
+                        exitCode = 2;
+                        return false;
+                    }
+                }
+                else if (arg == "--threads" || arg == "--commit-rows" || arg == "--commit-ms" ||
+                         arg == "--sort-memory-mb")
+                {
+                    char *end = nullptr;
+                    unsigned long count = std::strtoul(value.c_str(), &end, 10);
+                    // --threads 0 means one parser per hardware thread, like the default
+                    if (*end != '\0' || (count == 0 && arg != "--threads"))
+                    {
+                        std::fprintf(stderr, "Bad count for %s: %s\n", arg.c_str(), value.c_str());
+                        exitCode = 2;
+                        return false;
+                    }
+                    if (arg == "--threads")
+                        cli.import.parseThreads = count;
+                    else if (arg == "--commit-rows")
+                        cli.import.commitRows = count;
+                    else if (arg == "--commit-ms")
+                        cli.import.commitSeconds = count / 1000.0;
+                    else
+                        cli.import.sortMemoryBytes = static_cast<size_t>(count) << 20;
+                }
+                else if (!ParseSessionProfile(value, cli.import.profile))
+                {
+                    std::fprintf(stderr, "Unknown profile: %s\n", value.c_str());
+                    exitCode = 2;
+                    return false;
+                }
+            }
+            else if (!arg.empty() && arg[0] == '-')
+            {
+                std::fprintf(stderr, "Unknown or incomplete option: %s\n", arg.c_str());
+                exitCode = 2;
+                return false;
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.empty() || positional.size() > 2)
+        {
+            PrintUsage(argv[0]);
+            exitCode = 2;
+            return false;
+        }
+        if (cli.import.quarantine && cli.import.profile == SessionProfile::Staging)
+        {
+            std::fprintf(stderr, "--quarantine cannot be used with --profile staging, which has no rollback journal\n");
+            exitCode = 2;
+            return false;
+        }
+        cli.import.csvFolder = positional[0];
+        if (positional.size() == 2)
+            cli.import.dbPath = positional[1];
+        return true;
+    }
+
+    // Prints queued log lines; errors go to stderr as well when quiet
+    void FlushLog(const CliOptions &cli, LogFileWriter &logFile)
+    {
+        std::vector<LogRecord> records;
+        if (!AppLog().Drain(records))
+            return;
+
+        std::vector<std::string> lines;
+        lines.reserve(records.size());
+        for (const LogRecord &record : records)
+        {
+            std::string line = AppLog().Format(record);
+            bool isError = record.text.compare(0, 6, "ERROR:") == 0;
+            bool isReport = record.text.compare(0, 10, "Run report") == 0 || record.text.compare(0, 2, "  ") == 0;
+            if (isError)
+                std::fprintf(stderr, "%s\n", line.c_str());
+            else if (!cli.quiet || isReport)
+                std::printf("%s\n", line.c_str());
+            lines.push_back(std::move(line));
+        }
+        std::fflush(stdout);
+        logFile.Write(std::move(lines));
+    }
+
+    // One line per second at most, and only when something moved
+    void PrintProgress(const ProgressSnapshot &snapshot, ProgressSnapshot &last)
+    {
+        size_t phase = static_cast<size_t>(snapshot.phase);
+        if (snapshot.phase == last.phase && snapshot.rows[phase] == last.rows[phase])
+            return;
+        if (snapshot.phase >= ImportPhase::Matlist && snapshot.phase <= ImportPhase::RecipeLine)
+        {
+            std::printf("progress: %3d%% %s %llu rows, %.1f / %.1f MB\n", snapshot.Percent(),
+                        ImportPhaseName(snapshot.phase), static_cast<unsigned long long>(snapshot.rows[phase]),
+                        snapshot.bytesDone[phase] / 1e6, snapshot.bytesTotal[phase] / 1e6);
+            std::fflush(stdout);
+        }
+        last = snapshot;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    CliOptions cli;
+    int exitCode = 0;
+    if (!ParseArguments(argc, argv, cli, exitCode))
+        return exitCode;
+
+    LogFileWriter logFile;
+    if (!cli.logPath.empty() && !logFile.Open(cli.logPath))
+    {
+        std::fprintf(stderr, "Cannot open log file: %s\n", cli.logPath.c_str());
+        return 2;
+    }
+
+    ImportProgress progress;
+    ImportReport report;
+    std::atomic<bool> finished{false};
+    bool success = false;
+
+    std::thread worker([&] {
+        success = RunImport(cli.import, progress, report);
+        finished.store(true);
+    });
+
+    // The main thread only samples: log lines every 100 ms, progress every second
+    ProgressSnapshot last;
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (!finished.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        FlushLog(cli, logFile);
+        auto now = std::chrono::steady_clock::now();
+        if (!cli.quiet && now - lastProgress >= std::chrono::seconds(1))
+        {
+            PrintProgress(progress.Sample(), last);
+            lastProgress = now;
+        }
+    }
+    worker.join();
+    FlushLog(cli, logFile);
+    logFile.Close();
+
+    return success ? 0 : 1;
+}
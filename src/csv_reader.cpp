@@ -0,0 +1,349 @@
+#include "csv_reader.h"
+#include "number_parse.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+    // Unit of work for the parser pool; big enough to amortise the hand-off
+    constexpr size_t kChunkBytes = 1024 * 1024;
+
+    // A batch is handed on early once its text reaches this size
+    constexpr size_t kBatchArenaBytes = 256 * 1024 * 1024;
+
+    // Parses one row into 'batch'; a bad cell is recorded and ends the row
+    void AppendRow(const std::vector<CsvField> &fields, const TableColumns &columns, RowBatch &batch)
+    {
+        // Missing trailing cells stay null; extra cells are ignored
+        size_t row = batch.AddRow();
+        size_t present = fields.size() < columns.count ? fields.size() : columns.count;
+        for (size_t i = 0; i < present; i++)
+        {
+            if (!ParseCell(fields[i], columns.columns[i], batch, i, row))
+            {
+                batch.errors.push_back({row, i, std::string(columns.columns[i].name) + " is not a number: " +
+                                                    std::string(fields[i].text)});
+                break;
+            }
+        }
+    }
+
+    // Parses 'text' (which starts at file offset 'baseOffset') into batches of
+    // at most 'batchRows' rows. 'acquire' supplies empty batches, 'emit' takes
+    // each filled one; returning false from 'emit' stops.
+    template <typename Acquire, typename Emit>
+    bool ParseRange(std::string_view text, size_t baseOffset, const TableColumns &columns, size_t batchRows,
+                    Acquire acquire, Emit emit)
+    {
+        CsvScanner scanner(text);
+        std::vector<CsvField> fields;
+        RowBatchPtr batch = acquire();
+        batch->startOffset = baseOffset;
+
+        while (scanner.NextRow(fields))
+        {
+            AppendRow(fields, columns, *batch);
+            batch->rowEnds.push_back(baseOffset + scanner.Offset());
+            if (batch->rowCount == batchRows || batch->arena.size() >= kBatchArenaBytes)
+            {
+                batch->endOffset = baseOffset + scanner.Offset();
+                if (!emit(std::move(batch)))
+                    return false;
+                batch = acquire();
+                batch->startOffset = baseOffset + scanner.Offset();
+            }
+        }
+
+        if (batch->rowCount == 0)
+            return true;
+        batch->endOffset = baseOffset + scanner.Offset();
+        return emit(std::move(batch));
+    }
+
+    // First line start at or after 'pos'
+    size_t LineStartAtOrAfter(std::string_view text, size_t pos)
+    {
+        if (pos == 0)
+            return 0;
+        if (pos >= text.size())
+            return text.size();
+        const void *newline = std::memchr(text.data() + pos - 1, '\n', text.size() - pos + 1);
+        if (!newline)
+            return text.size();
+        return static_cast<const char *>(newline) - text.data() + 1;
+    }
+}
+
+bool ParseCell(const CsvField &field, const ColumnDesc &column, RowBatch &batch, size_t columnIndex, size_t row)
+{
+    if (field.text.empty())
+        return true;
+
+    switch (column.value.type)
+    {
+    case SqlType::Text:
+        if (column.key != KeyDomain::None)
+            batch.SetKey(columnIndex, row, field.text, (field.flags & FieldHasHighBytes) != 0);
+        else if (field.flags & FieldHasHighBytes)
+            batch.SetLatin1Text(columnIndex, row, field.text);
+        else
+            batch.SetText(columnIndex, row, field.text);
+        return true;
+
+    case SqlType::Real:
+    {
+        double real;
+        if (!ParseDecimal(field.text, real))
+            return false;
+        batch.SetReal(columnIndex, row, real);
+        return true;
+    }
+
+    case SqlType::Integer:
+    {
+        long long integer;
+        if (ParseInteger(field.text, integer))
+        {
+            batch.SetInteger(columnIndex, row, integer);
+            return true;
+        }
+        double real;
+        if (!ParseDecimal(field.text, real))
+            return false;
+        batch.SetReal(columnIndex, row, real);
+        return true;
+    }
+    }
+    return false;
+}
+
+CsvBatchReader::CsvBatchReader(TableColumns columns, size_t batchRows, size_t queueDepth, size_t threads,
+                               KeyDictionaries *keys)
+    : m_columns(columns), m_keys(keys), m_queue(queueDepth), m_batchRows(batchRows ? batchRows : 1),
+      m_threads(threads)
+{
+    if (m_threads == 0)
+        m_threads = std::thread::hardware_concurrency();
+    if (m_threads == 0)
+        m_threads = 1;
+}
+
+CsvBatchReader::~CsvBatchReader()
+{
+    Cancel();
+}
+
+bool CsvBatchReader::Start(const std::string &filename, size_t startOffset, size_t firstRow)
+{
+    if (!m_file.Open(filename))
+    {
+        m_error = m_file.Error();
+        m_failed = true;
+        return false;
+    }
+    m_startOffset = startOffset < m_file.Size() ? startOffset : m_file.Size();
+    m_firstRow = firstRow;
+
+    m_thread = std::thread(&CsvBatchReader::ParseThread, this);
+    return true;
+}
+
+bool CsvBatchReader::Next(RowBatchPtr &batch)
+{
+    if (batch)
+    {
+        std::lock_guard<std::mutex> lock(m_spareMutex);
+        m_spare.push_back(std::move(batch));
+    }
+    return m_queue.Pop(batch);
+}
+
+RowBatchPtr CsvBatchReader::AcquireBatch()
+{
+    RowBatchPtr batch;
+    {
+        std::lock_guard<std::mutex> lock(m_spareMutex);
+        if (!m_spare.empty())
+        {
+            batch = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+    }
+    if (!batch)
+        batch = std::make_unique<RowBatch>();
+    batch->Reset(m_columns, m_batchRows);
+    return batch;
+}
+
+void CsvBatchReader::Cancel()
+{
+    m_queue.Cancel();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void CsvBatchReader::ParseThread()
+{
+    try
+    {
+        size_t chunkCount = (m_file.Size() - m_startOffset + kChunkBytes - 1) / kChunkBytes;
+        if (m_threads > 1 && chunkCount > 1)
+            ParseChunks(chunkCount);
+        else
+            ParseSequential();
+    }
+    catch (const std::exception &e)
+    {
+        m_error = e.what();
+        m_failed = true;
+    }
+    catch (...)
+    {
+        m_error = "unknown parser error";
+        m_failed = true;
+    }
+    m_queue.Close();
+}
+
+void CsvBatchReader::ParseSequential()
+{
+    size_t rowsRead = m_firstRow;
+    ParseRange(
+        m_file.View().substr(m_startOffset), m_startOffset, m_columns, m_batchRows, [this] { return AcquireBatch(); },
+        [&](RowBatchPtr &&batch) {
+            if (m_keys)
+                batch->MergeKeys(*m_keys);
+            batch->firstRow = rowsRead;
+            rowsRead += batch->rowCount;
+            m_rowsRead = rowsRead;
+            return m_queue.Push(std::move(batch));
+        });
+}
+
+// This thread stitches: it takes finished chunks in file order, numbers their
+// rows and queues them. The workers claim chunks in order but may finish out
+// of order; each waits before starting a chunk that would not fit the window.
+void CsvBatchReader::ParseChunks(size_t chunkCount)
+{
+    struct Slot
+    {
+        std::vector<RowBatchPtr> batches;
+        bool ready = false;
+    };
+
+    const std::string_view text = m_file.View();
+    const size_t workerCount = m_threads < chunkCount ? m_threads : chunkCount;
+    const size_t window = workerCount * 2;
+
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<size_t> nextChunk{0};
+    size_t stitched = 0;
+    bool stop = false;
+    std::string workerError;
+
+    auto worker = [&] {
+        try
+        {
+            for (;;)
+            {
+                size_t chunk = nextChunk.fetch_add(1);
+                if (chunk >= chunkCount)
+                    return;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return stop || chunk < stitched + window; });
+                    if (stop)
+                        return;
+                }
+
+                size_t begin = LineStartAtOrAfter(text, m_startOffset + chunk * kChunkBytes);
+                size_t end = LineStartAtOrAfter(text, m_startOffset + (chunk + 1) * kChunkBytes);
+                std::vector<RowBatchPtr> batches;
+                if (begin < end)
+                {
+                    ParseRange(
+                        text.substr(begin, end - begin), begin, m_columns, m_batchRows,
+                        [this] { return AcquireBatch(); },
+                        [&](RowBatchPtr &&batch) {
+                            batches.push_back(std::move(batch));
+                            return true;
+                        });
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                Slot &slot = slots[chunk % window];
+                slot.batches = std::move(batches);
+                slot.ready = true;
+                changed.notify_all();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (workerError.empty())
+                workerError = e.what();
+            stop = true;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+        workers.emplace_back(worker);
+
+    size_t rowsRead = m_firstRow;
+    for (size_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        std::vector<RowBatchPtr> batches;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Slot &slot = slots[chunk % window];
+            changed.wait(lock, [&] { return stop || slot.ready; });
+            if (stop)
+                break;
+            batches = std::move(slot.batches);
+            slot.ready = false;
+        }
+
+        bool cancelled = false;
+        for (RowBatchPtr &batch : batches)
+        {
+            if (m_keys)
+                batch->MergeKeys(*m_keys);
+            batch->firstRow = rowsRead;
+            rowsRead += batch->rowCount;
+            m_rowsRead = rowsRead;
+            if (!m_queue.Push(std::move(batch)))
+            {
+                cancelled = true;
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stitched = chunk + 1;
+        if (cancelled)
+            stop = true;
+        changed.notify_all();
+        if (cancelled)
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        changed.notify_all();
+    }
+    for (std::thread &thread : workers)
+        thread.join();
+
+    if (!workerError.empty())
+    {
+        m_error = workerError;
+        m_failed = true;
+    }
+}
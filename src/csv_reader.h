@@ -0,0 +1,81 @@
+// Streaming CSV reader: parses on a background thread into bounded row batches
+#pragma once
+
+#include "bounded_queue.h"
+#include "csv_scanner.h"
+#include "mapped_file.h"
+#include "row_batch.h"
+#include "table_schema.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Parses a raw field for 'column' into cell (column, row) of 'batch'. Empty
+// cells stay null and bind the column default. An INTEGER cell such as "1,5"
+// is kept as a real. Returns false if a numeric cell is not a number.
+bool ParseCell(const CsvField &field, const ColumnDesc &column, RowBatch &batch, size_t columnIndex, size_t row);
+
+// Parses one CSV file while the consumer works on earlier batches. At most
+// 'queueDepth' batches of 'batchRows' rows are queued at once, so memory use
+// does not depend on the file size.
+//
+// With more than one thread the file is cut into line-aligned chunks that a
+// worker pool parses independently (rows carry no state across lines). The
+// batches are stitched back into file order before they are queued; workers
+// stay at most two chunks per thread ahead of the consumer.
+class CsvBatchReader
+{
+public:
+    // 'threads' = 0 uses one parser per hardware thread. With 'keys', key
+    // columns carry dictionary ids; batches are merged in file order.
+    CsvBatchReader(TableColumns columns, size_t batchRows, size_t queueDepth, size_t threads = 1,
+                   KeyDictionaries *keys = nullptr);
+    ~CsvBatchReader();
+
+    CsvBatchReader(const CsvBatchReader &) = delete;
+    CsvBatchReader &operator=(const CsvBatchReader &) = delete;
+
+    // Maps the file and starts the parser thread. A resumed import starts at
+    // 'startOffset', which must be a line start, and numbers that row 'firstRow'.
+    bool Start(const std::string &filename, size_t startOffset = 0, size_t firstRow = 0);
+
+    // Next batch in file order; false at end of file, on error or after Cancel.
+    // A batch already held in 'batch' is handed back to the parser for reuse.
+    bool Next(RowBatchPtr &batch);
+
+    // Stops the parser thread early and discards queued batches
+    void Cancel();
+
+    size_t FileSize() const { return m_file.Size(); }
+    std::string_view FileText() const { return m_file.View(); } // valid once Start() succeeded
+    size_t Threads() const { return m_threads; }
+    size_t RowsRead() const { return m_rowsRead.load(); }
+    bool Failed() const { return m_failed.load(); }
+    const std::string &Error() const { return m_error; }
+
+private:
+    void ParseThread();
+    void ParseSequential();
+    void ParseChunks(size_t chunkCount);
+    RowBatchPtr AcquireBatch();
+
+    TableColumns m_columns;
+    KeyDictionaries *m_keys;
+    MappedFile m_file;
+    BoundedQueue<RowBatchPtr> m_queue;
+    std::mutex m_spareMutex;
+    std::vector<RowBatchPtr> m_spare; // consumed batches, refilled before new ones are made
+    size_t m_batchRows;
+    size_t m_threads;
+    size_t m_startOffset = 0;
+    size_t m_firstRow = 0;
+    std::thread m_thread;
+    std::atomic<size_t> m_rowsRead{0};
+    std::atomic<bool> m_failed{false};
+    std::string m_error;
+};
@@ -0,0 +1,97 @@
+#include "csv_scanner.h"
+
+namespace
+{
+    // Tokenize this much at a time so the token index stays cache resident
+    constexpr size_t kBlockSize = 256 * 1024;
+}
+
+std::string_view TrimCell(std::string_view cell)
+{
+    size_t first = cell.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+        return std::string_view();
+    size_t last = cell.find_last_not_of(" \t\r\n");
+    return cell.substr(first, last - first + 1);
+}
+
+CsvScanner::CsvScanner(std::string_view buffer)
+    : m_buffer(buffer), m_kernel(ActiveTokenizerKernel())
+{
+}
+
+// Tokenizes the next run of complete lines. A block only ends early on a
+// line boundary; it grows until it holds at least one '\n' or reaches EOF.
+bool CsvScanner::FillBlock()
+{
+    m_blockStart += m_blockSize;
+    m_blockSize = 0;
+    m_lineStart = 0;
+    m_tokenIndex = 0;
+    m_tokens.clear();
+
+    size_t remaining = m_buffer.size() - m_blockStart;
+    if (remaining == 0)
+        return false;
+
+    const char *data = m_buffer.data() + m_blockStart;
+    size_t length = remaining < kBlockSize ? remaining : kBlockSize;
+    while (true)
+    {
+        uint8_t pending = TokenizeBlock(data, length, m_tokens, m_kernel);
+
+        if (length == remaining)
+        {
+            // Last line without a trailing '\n' still ends the input
+            if (data[length - 1] != '\n')
+                m_tokens.push_back({static_cast<uint32_t>(length), static_cast<uint8_t>(pending | FieldEndsLine)});
+            m_blockSize = length;
+            return true;
+        }
+
+        size_t keep = m_tokens.size();
+        while (keep > 0 && !(m_tokens[keep - 1].flags & FieldEndsLine))
+            keep--;
+        if (keep > 0)
+        {
+            m_tokens.resize(keep);
+            m_blockSize = m_tokens.back().offset + 1;
+            return true;
+        }
+
+        // A single line longer than the block; retry with a larger one
+        m_tokens.clear();
+        length = remaining - length < length ? remaining : length * 2;
+    }
+}
+
+bool CsvScanner::NextRow(std::vector<CsvField> &fields)
+{
+    fields.clear();
+
+    while (fields.empty())
+    {
+        if (m_tokenIndex == m_tokens.size() && !FillBlock())
+            return false;
+
+        const char *block = m_buffer.data() + m_blockStart;
+        size_t fieldStart = m_lineStart;
+        while (true)
+        {
+            const CsvToken &token = m_tokens[m_tokenIndex++];
+            std::string_view raw(block + fieldStart, token.offset - fieldStart);
+            bool endsLine = (token.flags & FieldEndsLine) != 0;
+
+            // getline drops the empty piece after a trailing ';'
+            if (!endsLine || !raw.empty())
+                fields.push_back({TrimCell(raw), static_cast<uint8_t>(token.flags & ~FieldEndsLine)});
+
+            fieldStart = token.offset + 1;
+            if (endsLine)
+                break;
+        }
+        m_lineStart = fieldStart < m_blockSize ? fieldStart : m_blockSize;
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+// Zero-copy scanner for the ';' separated ERP exports
+#pragma once
+
+#include "csv_tokenizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// A trimmed field view plus the CsvFieldFlags found while tokenizing it
+struct CsvField
+{
+    std::string_view text;
+    uint8_t flags;
+};
+
+// Splits a buffer into rows of trimmed fields. Fields are views into the
+// buffer, so it must outlive every row returned. Splitting follows the
+// original getline-based reader: a trailing ';' does not produce an empty
+// field, and lines without any field are skipped.
+class CsvScanner
+{
+public:
+    explicit CsvScanner(std::string_view buffer);
+
+    // Fills 'fields' with the next non-empty row; returns false at end of input
+    bool NextRow(std::vector<CsvField> &fields);
+
+    // Byte offset of the first unconsumed line
+    size_t Offset() const { return m_blockStart + m_lineStart; }
+
+private:
+    bool FillBlock();
+
+    std::string_view m_buffer;
+    CsvTokenizerKernel m_kernel;
+    std::vector<CsvToken> m_tokens;
+    size_t m_tokenIndex = 0;
+    size_t m_blockStart = 0;
+    size_t m_blockSize = 0;
+    size_t m_lineStart = 0;
+};
+
+// Strips the " \t\r\n" characters the original reader trimmed from each cell
+std::string_view TrimCell(std::string_view cell);
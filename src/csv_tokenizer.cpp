@@ -0,0 +1,225 @@
+#include "csv_tokenizer.h"
+#include "simd_support.h"
+
+#include <atomic>
+
+namespace
+{
+    // Character class bitmasks for a 64-byte word, one bit per byte
+    struct WordMasks
+    {
+        uint64_t separator;
+        uint64_t newline;
+        uint64_t high;
+        uint64_t comma;
+        uint64_t quote;
+        uint64_t carriageReturn;
+    };
+
+    inline unsigned CountTrailingZeros(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+    }
+
+    inline uint8_t FlagsIn(const WordMasks &m, uint64_t range)
+    {
+        uint8_t flags = 0;
+        if (m.high & range)
+            flags |= FieldHasHighBytes;
+        if (m.comma & range)
+            flags |= FieldHasComma;
+        if (m.quote & range)
+            flags |= FieldHasQuote;
+        if (m.carriageReturn & range)
+            flags |= FieldHasCarriageReturn;
+        return flags;
+    }
+
+    // Turns the masks of one word into tokens; 'pending' carries the flags of
+    // a field that started in an earlier word
+    inline void EmitWord(const WordMasks &m, uint32_t base, uint8_t &pending, std::vector<CsvToken> &tokens)
+    {
+        uint64_t structural = m.separator | m.newline;
+        uint64_t consumed = 0;
+
+        while (structural)
+        {
+            unsigned bit = CountTrailingZeros(structural);
+            uint64_t below = (uint64_t(1) << bit) - 1;
+            uint8_t flags = pending | FlagsIn(m, below & ~consumed);
+            if ((m.newline >> bit) & 1)
+                flags |= FieldEndsLine;
+
+            tokens.push_back({base + bit, flags});
+            pending = 0;
+            consumed = below | (uint64_t(1) << bit);
+            structural &= structural - 1;
+        }
+
+        pending |= FlagsIn(m, ~consumed);
+    }
+
+    WordMasks ScalarMasks(const char *data, size_t size)
+    {
+        WordMasks m = {};
+        for (size_t i = 0; i < size; i++)
+        {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            uint64_t bit = uint64_t(1) << i;
+            if (c == ';')
+                m.separator |= bit;
+            else if (c == '\n')
+                m.newline |= bit;
+            else if (c == ',')
+                m.comma |= bit;
+            else if (c == '"')
+                m.quote |= bit;
+            else if (c == '\r')
+                m.carriageReturn |= bit;
+            else if (c >= 0x80)
+                m.high |= bit;
+        }
+        return m;
+    }
+
+    uint8_t TokenizeScalar(const char *data, size_t size, std::vector<CsvToken> &tokens)
+    {
+        uint8_t pending = 0;
+        for (size_t pos = 0; pos < size; pos += 64)
+        {
+            size_t len = size - pos < 64 ? size - pos : 64;
+            EmitWord(ScalarMasks(data + pos, len), static_cast<uint32_t>(pos), pending, tokens);
+        }
+        return pending;
+    }
+
+#ifdef BAKERY_HAS_SSE2
+    inline uint64_t Mask16(__m128i chunk, char c)
+    {
+        return static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c))));
+    }
+
+    uint8_t TokenizeSse2(const char *data, size_t size, std::vector<CsvToken> &tokens)
+    {
+        uint8_t pending = 0;
+        size_t pos = 0;
+        for (; pos + 64 <= size; pos += 64)
+        {
+            WordMasks m = {};
+            for (int lane = 0; lane < 4; lane++)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos + lane * 16));
+                int shift = lane * 16;
+                m.separator |= Mask16(chunk, ';') << shift;
+                m.newline |= Mask16(chunk, '\n') << shift;
+                m.comma |= Mask16(chunk, ',') << shift;
+                m.quote |= Mask16(chunk, '"') << shift;
+                m.carriageReturn |= Mask16(chunk, '\r') << shift;
+                m.high |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(chunk))) << shift;
+            }
+            EmitWord(m, static_cast<uint32_t>(pos), pending, tokens);
+        }
+        if (pos < size)
+            EmitWord(ScalarMasks(data + pos, size - pos), static_cast<uint32_t>(pos), pending, tokens);
+        return pending;
+    }
+
+    BAKERY_TARGET_AVX2 inline uint64_t Mask32(__m256i chunk, char c)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c))));
+    }
+
+    BAKERY_TARGET_AVX2 uint8_t TokenizeAvx2(const char *data, size_t size, std::vector<CsvToken> &tokens)
+    {
+        uint8_t pending = 0;
+        size_t pos = 0;
+        for (; pos + 64 <= size; pos += 64)
+        {
+            __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+            __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos + 32));
+
+            WordMasks m;
+            m.separator = Mask32(lo, ';') | (Mask32(hi, ';') << 32);
+            m.newline = Mask32(lo, '\n') | (Mask32(hi, '\n') << 32);
+            m.comma = Mask32(lo, ',') | (Mask32(hi, ',') << 32);
+            m.quote = Mask32(lo, '"') | (Mask32(hi, '"') << 32);
+            m.carriageReturn = Mask32(lo, '\r') | (Mask32(hi, '\r') << 32);
+            m.high = uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(lo))) |
+                     (uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+            EmitWord(m, static_cast<uint32_t>(pos), pending, tokens);
+        }
+        if (pos < size)
+            EmitWord(ScalarMasks(data + pos, size - pos), static_cast<uint32_t>(pos), pending, tokens);
+        return pending;
+    }
+
+#endif
+
+    std::atomic<int> g_activeKernel{-1};
+}
+
+CsvTokenizerKernel DetectTokenizerKernel()
+{
+    switch (DetectSimdLevel())
+    {
+    case SimdLevel::Avx2:
+        return CsvTokenizerKernel::Avx2;
+    case SimdLevel::Sse2:
+        return CsvTokenizerKernel::Sse2;
+    default:
+        return CsvTokenizerKernel::Scalar;
+    }
+}
+
+CsvTokenizerKernel ActiveTokenizerKernel()
+{
+    int kernel = g_activeKernel.load(std::memory_order_relaxed);
+    if (kernel < 0)
+        return DetectTokenizerKernel();
+    return static_cast<CsvTokenizerKernel>(kernel);
+}
+
+void SetActiveTokenizerKernel(CsvTokenizerKernel kernel)
+{
+    // Never select a kernel the CPU cannot run
+    if (kernel == CsvTokenizerKernel::Avx2 && DetectTokenizerKernel() != CsvTokenizerKernel::Avx2)
+        kernel = DetectTokenizerKernel();
+    if (kernel == CsvTokenizerKernel::Sse2 && DetectTokenizerKernel() == CsvTokenizerKernel::Scalar)
+        kernel = CsvTokenizerKernel::Scalar;
+    g_activeKernel.store(static_cast<int>(kernel), std::memory_order_relaxed);
+}
+
+const char *TokenizerKernelName(CsvTokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+    case CsvTokenizerKernel::Avx2:
+        return "AVX2";
+    case CsvTokenizerKernel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+uint8_t TokenizeBlock(const char *data, size_t size, std::vector<CsvToken> &tokens,
+                      CsvTokenizerKernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef BAKERY_HAS_SSE2
+    case CsvTokenizerKernel::Avx2:
+        return TokenizeAvx2(data, size, tokens);
+    case CsvTokenizerKernel::Sse2:
+        return TokenizeSse2(data, size, tokens);
+#endif
+    default:
+        return TokenizeScalar(data, size, tokens);
+    }
+}
@@ -0,0 +1,44 @@
+// Vectorized structural scan for the ';' separated ERP exports
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-field flags gathered while scanning, so later stages can skip work
+enum CsvFieldFlags : uint8_t
+{
+    FieldHasHighBytes = 0x01, // ISO-8859-1 bytes >= 0x80, needs transcoding
+    FieldHasComma = 0x02,     // decimal comma candidate
+    FieldHasQuote = 0x04,     // contains '"' (kept literally, like the original reader)
+    FieldHasCarriageReturn = 0x08,
+    FieldEndsLine = 0x80      // token is a '\n' rather than a ';'
+};
+
+// One field terminator: the field runs from the previous terminator up to 'offset'
+struct CsvToken
+{
+    uint32_t offset;
+    uint8_t flags;
+};
+
+enum class CsvTokenizerKernel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Best kernel supported by this CPU (detected once)
+CsvTokenizerKernel DetectTokenizerKernel();
+
+// Kernel used by CsvScanner; defaults to DetectTokenizerKernel()
+CsvTokenizerKernel ActiveTokenizerKernel();
+void SetActiveTokenizerKernel(CsvTokenizerKernel kernel);
+
+const char *TokenizerKernelName(CsvTokenizerKernel kernel);
+
+// Appends a token for every ';' and '\n' in data[0, size). Returns the flags of
+// the unterminated field after the last token. Blocks are limited to 4 GiB.
+uint8_t TokenizeBlock(const char *data, size_t size, std::vector<CsvToken> &tokens,
+                      CsvTokenizerKernel kernel);
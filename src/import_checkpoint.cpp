@@ -0,0 +1,122 @@
+#include "import_checkpoint.h"
+#include "import_manifest.h"
+
+namespace
+{
+    constexpr size_t kHashBlockBytes = 1024 * 1024;
+}
+
+uint64_t PrefixHasher::Hash(size_t length)
+{
+    if (length > m_text.size())
+        length = m_text.size();
+
+    size_t blocks = length / kHashBlockBytes;
+    if (blocks < m_blocks)
+    {
+        m_blocks = 0;
+        m_chain = 0;
+    }
+    for (; m_blocks < blocks; m_blocks++)
+        m_chain = ContentHash64(m_text.data() + m_blocks * kHashBlockBytes, kHashBlockBytes, m_chain);
+
+    size_t tail = blocks * kHashBlockBytes;
+    return ContentHash64(m_text.data() + tail, length - tail, m_chain);
+}
+
+bool ImportCheckpoints::Open(sqlite3 *db, std::string &error)
+{
+    m_db = db;
+    char *errMsg = nullptr;
+    int rc = sqlite3_exec(db,
+                          "CREATE TABLE IF NOT EXISTS ImportCheckpoint (\n"
+                          "    FileName TEXT PRIMARY KEY,\n"
+                          "    ByteOffset INTEGER NOT NULL,\n"
+                          "    RowNumber INTEGER NOT NULL,\n"
+                          "    PrefixHash INTEGER NOT NULL,\n"
+                          "    Settings TEXT NOT NULL,\n"
+                          "    UpdatedAt TEXT NOT NULL\n"
+                          ");\n",
+                          nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        error = errMsg ? errMsg : "Unknown";
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+bool ImportCheckpoints::Find(const std::string &fileName, ResumePoint &point, std::string &settings, bool &found,
+                             std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db,
+                           "SELECT ByteOffset, RowNumber, PrefixHash, Settings FROM ImportCheckpoint "
+                           "WHERE FileName = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    found = rc == SQLITE_ROW;
+    if (found)
+    {
+        point.byteOffset = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        point.rowNumber = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+        point.prefixHash = static_cast<uint64_t>(sqlite3_column_int64(stmt, 2));
+        const unsigned char *text = sqlite3_column_text(stmt, 3);
+        settings = text ? reinterpret_cast<const char *>(text) : "";
+    }
+    else if (rc != SQLITE_DONE)
+    {
+        error = sqlite3_errmsg(m_db);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_ROW || rc == SQLITE_DONE;
+}
+
+bool ImportCheckpoints::Save(const std::string &fileName, const std::string &settings, const ResumePoint &point,
+                             std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db,
+                           "INSERT OR REPLACE INTO ImportCheckpoint VALUES (?, ?, ?, ?, ?, datetime('now'))", -1,
+                           &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(point.byteOffset));
+    sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(point.rowNumber));
+    sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(point.prefixHash));
+    sqlite3_bind_text(stmt, 5, settings.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(m_db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool ImportCheckpoints::Clear(const std::string &fileName, std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, "DELETE FROM ImportCheckpoint WHERE FileName = ?", -1, &stmt, nullptr) !=
+        SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(m_db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
@@ -0,0 +1,54 @@
+// Where an interrupted import of a CSV file stopped, so a rerun can resume there
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Position after the last committed row of a file
+struct ResumePoint
+{
+    uint64_t byteOffset = 0; // start of the first row still to import
+    uint64_t rowNumber = 0;  // rows of the file before 'byteOffset'
+    uint64_t prefixHash = 0; // PrefixHasher value of the bytes before 'byteOffset'
+};
+
+// Hash of a file's first n bytes. Whole 1 MiB blocks are chained, each hashed
+// with the previous value as seed, so a growing n costs one pass overall; the
+// bytes after the last whole block are hashed on every call.
+class PrefixHasher
+{
+public:
+    // 'text' is the mapped file and must outlive the hasher
+    explicit PrefixHasher(std::string_view text) : m_text(text) {}
+
+    // Cheapest when 'length' does not decrease between calls
+    uint64_t Hash(size_t length);
+
+private:
+    std::string_view m_text;
+    size_t m_blocks = 0; // whole blocks in m_chain
+    uint64_t m_chain = 0;
+};
+
+// The ImportCheckpoint table: one row per CSV file name whose import has
+// committed some chunks but not finished. It is written in the transaction
+// of each chunk, so it always matches the rows in the database.
+class ImportCheckpoints
+{
+public:
+    bool Open(sqlite3 *db, std::string &error);
+
+    // 'found' is false when the file has no checkpoint; 'settings' are those it was written under
+    bool Find(const std::string &fileName, ResumePoint &point, std::string &settings, bool &found,
+              std::string &error);
+    bool Save(const std::string &fileName, const std::string &settings, const ResumePoint &point,
+              std::string &error);
+    bool Clear(const std::string &fileName, std::string &error);
+
+private:
+    sqlite3 *m_db = nullptr;
+};
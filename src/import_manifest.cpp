@@ -0,0 +1,227 @@
+#include "import_manifest.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t RotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    uint64_t Read64(const unsigned char *p)
+    {
+        uint64_t value;
+        std::memcpy(&value, p, 8);
+        return value;
+    }
+
+    uint32_t Read32(const unsigned char *p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, 4);
+        return value;
+    }
+
+    uint64_t Round(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * kPrime2;
+        return RotateLeft(accumulator, 31) * kPrime1;
+    }
+
+    uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+    {
+        hash ^= Round(0, accumulator);
+        return hash * kPrime1 + kPrime4;
+    }
+}
+
+uint64_t ContentHash64(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *end = p + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        // Four independent lanes keep the multipliers busy
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const unsigned char *limit = end - 32;
+        do
+        {
+            v1 = Round(v1, Read64(p));
+            v2 = Round(v2, Read64(p + 8));
+            v3 = Round(v3, Read64(p + 16));
+            v4 = Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + kPrime5;
+    }
+
+    hash += size;
+    for (; p + 8 <= end; p += 8)
+        hash = RotateLeft(hash ^ Round(0, Read64(p)), 27) * kPrime1 + kPrime4;
+    if (p + 4 <= end)
+    {
+        hash = RotateLeft(hash ^ (Read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        hash = RotateLeft(hash ^ (*p * kPrime5), 11) * kPrime1;
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    return hash ^ (hash >> 32);
+}
+
+bool StatFile(const std::string &path, FileFingerprint &fingerprint, std::string &error)
+{
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec)
+    {
+        error = ec.message();
+        return false;
+    }
+    auto modified = fs::last_write_time(path, ec);
+    if (ec)
+    {
+        error = ec.message();
+        return false;
+    }
+    fingerprint.size = size;
+    fingerprint.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    fingerprint.hashed = false;
+    return true;
+}
+
+bool HashFile(const std::string &path, FileFingerprint &fingerprint, std::string &error)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        error = file.Error();
+        return false;
+    }
+    fingerprint.contentHash = ContentHash64(file.Data(), file.Size());
+    fingerprint.hashed = true;
+    return true;
+}
+
+bool FingerprintFile(const std::string &path, FileFingerprint &fingerprint, std::string &error)
+{
+    return StatFile(path, fingerprint, error) && HashFile(path, fingerprint, error);
+}
+
+bool ImportManifest::Open(sqlite3 *db, std::string &error)
+{
+    m_db = db;
+    char *errMsg = nullptr;
+    int rc = sqlite3_exec(db,
+                          "CREATE TABLE IF NOT EXISTS ImportManifest (\n"
+                          "    FileName TEXT PRIMARY KEY,\n"
+                          "    Size INTEGER NOT NULL,\n"
+                          "    ModifiedTime INTEGER NOT NULL,\n"
+                          "    ContentHash INTEGER NOT NULL,\n"
+                          "    Settings TEXT NOT NULL,\n"
+                          "    ImportedAt TEXT NOT NULL\n"
+                          ");\n",
+                          nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        error = errMsg ? errMsg : "Unknown";
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+bool ImportManifest::IsUnchanged(const std::string &fileName, const std::string &path, const std::string &settings,
+                                 FileFingerprint &fingerprint, std::string &error)
+{
+    if (!StatFile(path, fingerprint, error))
+        return false;
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db,
+                           "SELECT Size, ModifiedTime, ContentHash FROM ImportManifest "
+                           "WHERE FileName = ? AND Settings = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, settings.c_str(), -1, SQLITE_STATIC);
+
+    FileFingerprint stored;
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found)
+    {
+        stored.size = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        stored.modifiedTime = sqlite3_column_int64(stmt, 1);
+        stored.contentHash = static_cast<uint64_t>(sqlite3_column_int64(stmt, 2));
+    }
+    sqlite3_finalize(stmt);
+
+    if (found && stored.size == fingerprint.size && stored.modifiedTime == fingerprint.modifiedTime)
+        return true;
+
+    // Recorded if the file is imported; also tells a touched but identical file apart
+    if (!HashFile(path, fingerprint, error))
+        return false;
+    if (!found || stored.size != fingerprint.size || stored.contentHash != fingerprint.contentHash)
+        return false;
+
+    // Same bytes under a new mtime: remember the mtime so the next check is cheap again
+    Record(fileName, fingerprint, settings, error);
+    return true;
+}
+
+bool ImportManifest::Record(const std::string &fileName, const FileFingerprint &fingerprint,
+                            const std::string &settings, std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db,
+                           "INSERT OR REPLACE INTO ImportManifest VALUES (?, ?, ?, ?, ?, datetime('now'))", -1,
+                           &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(fingerprint.size));
+    sqlite3_bind_int64(stmt, 3, fingerprint.modifiedTime);
+    sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(fingerprint.contentHash));
+    sqlite3_bind_text(stmt, 5, settings.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(m_db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
@@ -0,0 +1,46 @@
+// Per-file record of what was last imported, so unchanged CSV files can be skipped
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// XXH64 of a byte range
+uint64_t ContentHash64(const void *data, size_t size, uint64_t seed = 0);
+
+// Size and modification time are cheap to read; the hash needs one pass
+// over the mapped file and is only taken when they do not settle it
+struct FileFingerprint
+{
+    uint64_t size = 0;
+    int64_t modifiedTime = 0; // file clock ticks, only compared for equality
+    uint64_t contentHash = 0;
+    bool hashed = false;
+};
+
+bool StatFile(const std::string &path, FileFingerprint &fingerprint, std::string &error);
+bool HashFile(const std::string &path, FileFingerprint &fingerprint, std::string &error);
+bool FingerprintFile(const std::string &path, FileFingerprint &fingerprint, std::string &error); // both
+
+// The ImportManifest table: one row per CSV file name with the fingerprint
+// of the file last imported and the settings that shaped its rows
+class ImportManifest
+{
+public:
+    bool Open(sqlite3 *db, std::string &error);
+
+    // True when 'path' holds what was last imported under 'fileName' with the
+    // same settings. Size and mtime matching is enough; with equal size but a
+    // new mtime the content hash decides. On return 'fingerprint' describes the
+    // file as it is now, hashed unless size and mtime already matched.
+    bool IsUnchanged(const std::string &fileName, const std::string &path, const std::string &settings,
+                     FileFingerprint &fingerprint, std::string &error);
+
+    bool Record(const std::string &fileName, const FileFingerprint &fingerprint, const std::string &settings,
+                std::string &error);
+
+private:
+    sqlite3 *m_db = nullptr;
+};
@@ -0,0 +1,101 @@
+#include "import_progress.h"
+
+namespace
+{
+    // Start and width of each phase on the 0-100 bar
+    struct PhaseRange
+    {
+        int start;
+        int span;
+    };
+
+    const PhaseRange kRanges[] = {
+        {0, 0},   // Idle
+        {5, 5},   // Preparing
+        {10, 30}, // Matlist
+        {40, 30}, // RecipeHead
+        {70, 25}, // RecipeLine
+        {100, 0}  // Done
+    };
+
+    size_t Index(ImportPhase phase)
+    {
+        return static_cast<size_t>(phase);
+    }
+}
+
+const char *ImportPhaseName(ImportPhase phase)
+{
+    switch (phase)
+    {
+    case ImportPhase::Preparing:
+        return "Preparing";
+    case ImportPhase::Matlist:
+        return "Matlist";
+    case ImportPhase::RecipeHead:
+        return "RecipeHead";
+    case ImportPhase::RecipeLine:
+        return "RecipeLine";
+    case ImportPhase::Done:
+        return "Done";
+    default:
+        return "Idle";
+    }
+}
+
+int ProgressSnapshot::Percent() const
+{
+    const PhaseRange &range = kRanges[Index(phase)];
+    uint64_t total = bytesTotal[Index(phase)];
+    if (total == 0 || range.span == 0)
+        return range.start;
+    uint64_t done = bytesDone[Index(phase)];
+    if (done > total)
+        done = total;
+    return range.start + static_cast<int>((range.span * done) / total);
+}
+
+void ImportProgress::Reset()
+{
+    for (size_t i = 0; i < kPhases; i++)
+    {
+        m_rows[i].store(0, std::memory_order_relaxed);
+        m_bytesDone[i].store(0, std::memory_order_relaxed);
+        m_bytesTotal[i].store(0, std::memory_order_relaxed);
+    }
+    m_phase.store(static_cast<int>(ImportPhase::Idle), std::memory_order_release);
+}
+
+void ImportProgress::BeginPhase(ImportPhase phase, uint64_t totalBytes)
+{
+    m_bytesTotal[Index(phase)].store(totalBytes, std::memory_order_relaxed);
+    m_phase.store(static_cast<int>(phase), std::memory_order_release);
+}
+
+void ImportProgress::AddRows(ImportPhase phase, uint64_t rows)
+{
+    m_rows[Index(phase)].fetch_add(rows, std::memory_order_relaxed);
+}
+
+void ImportProgress::SetBytes(ImportPhase phase, uint64_t bytes)
+{
+    m_bytesDone[Index(phase)].store(bytes, std::memory_order_relaxed);
+}
+
+void ImportProgress::Finish()
+{
+    m_phase.store(static_cast<int>(ImportPhase::Done), std::memory_order_release);
+}
+
+ProgressSnapshot ImportProgress::Sample() const
+{
+    ProgressSnapshot snapshot;
+    snapshot.phase = static_cast<ImportPhase>(m_phase.load(std::memory_order_acquire));
+    for (size_t i = 0; i < kPhases; i++)
+    {
+        snapshot.rows[i] = m_rows[i].load(std::memory_order_relaxed);
+        snapshot.bytesDone[i] = m_bytesDone[i].load(std::memory_order_relaxed);
+        snapshot.bytesTotal[i] = m_bytesTotal[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
@@ -0,0 +1,54 @@
+// Lock-free import progress: the worker publishes counters, any UI samples them
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class ImportPhase : int
+{
+    Idle,
+    Preparing,
+    Matlist,
+    RecipeHead,
+    RecipeLine,
+    Done,
+    Count
+};
+
+const char *ImportPhaseName(ImportPhase phase);
+
+// Plain copy of the counters at one instant
+struct ProgressSnapshot
+{
+    ImportPhase phase = ImportPhase::Idle;
+    std::array<uint64_t, static_cast<size_t>(ImportPhase::Count)> rows{};
+    std::array<uint64_t, static_cast<size_t>(ImportPhase::Count)> bytesDone{};
+    std::array<uint64_t, static_cast<size_t>(ImportPhase::Count)> bytesTotal{};
+
+    // Overall 0-100 position, weighted like the original progress bar
+    int Percent() const;
+};
+
+// Writers only store relaxed atomics, so publishing never waits on a reader.
+// Readers poll (a WM_TIMER in the GUI, a loop in a headless front-end).
+class ImportProgress
+{
+public:
+    void Reset();
+    void BeginPhase(ImportPhase phase, uint64_t totalBytes = 0);
+    void AddRows(ImportPhase phase, uint64_t rows);
+    void SetBytes(ImportPhase phase, uint64_t bytes);
+    void Finish();
+
+    ProgressSnapshot Sample() const;
+
+private:
+    static constexpr size_t kPhases = static_cast<size_t>(ImportPhase::Count);
+
+    std::atomic<int> m_phase{0};
+    std::array<std::atomic<uint64_t>, kPhases> m_rows{};
+    std::array<std::atomic<uint64_t>, kPhases> m_bytesDone{};
+    std::array<std::atomic<uint64_t>, kPhases> m_bytesTotal{};
+};
@@ -0,0 +1,74 @@
+#include "import_rejects.h"
+#include "transcode.h"
+
+ImportRejects::~ImportRejects()
+{
+    sqlite3_finalize(m_add);
+}
+
+bool ImportRejects::Open(sqlite3 *db, std::string &error)
+{
+    m_db = db;
+    char *errMsg = nullptr;
+    int rc = sqlite3_exec(db,
+                          "CREATE TABLE IF NOT EXISTS ImportRejects (\n"
+                          "    FileName TEXT NOT NULL,\n"
+                          "    RowNumber INTEGER NOT NULL,\n"
+                          "    RawLine TEXT,\n"
+                          "    Reason TEXT NOT NULL,\n"
+                          "    RejectedAt TEXT NOT NULL\n"
+                          ");\n",
+                          nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        error = errMsg ? errMsg : "Unknown";
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    if (sqlite3_prepare_v3(db, "INSERT INTO ImportRejects VALUES (?, ?, ?, ?, datetime('now'))", -1,
+                           SQLITE_PREPARE_PERSISTENT, &m_add, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+bool ImportRejects::Clear(const std::string &fileName, std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, "DELETE FROM ImportRejects WHERE FileName = ?", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, fileName.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(m_db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool ImportRejects::Add(const std::string &fileName, size_t row, std::string_view rawLine,
+                        const std::string &reason, std::string &error)
+{
+    // The CSV files are ISO-8859-1, as the reader assumes for their cells
+    std::string line = ConvertISO88591ToUTF8(rawLine);
+
+    sqlite3_bind_text(m_add, 1, fileName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(m_add, 2, static_cast<sqlite3_int64>(row));
+    if (rawLine.empty())
+        sqlite3_bind_null(m_add, 3);
+    else
+        sqlite3_bind_text(m_add, 3, line.data(), static_cast<int>(line.size()), SQLITE_STATIC);
+    sqlite3_bind_text(m_add, 4, reason.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(m_add);
+    sqlite3_reset(m_add);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(m_db);
+    return rc == SQLITE_DONE;
+}
@@ -0,0 +1,35 @@
+// Rows a quarantine import left out, kept in the database for review
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// The ImportRejects table: one row per CSV row that a quarantine import did
+// not write, with the line as it is in the file (converted to UTF-8), its row
+// index as the log counts it and why it was left out. A file that is imported
+// again from the start replaces its rows.
+class ImportRejects
+{
+public:
+    ImportRejects() = default;
+    ~ImportRejects();
+
+    ImportRejects(const ImportRejects &) = delete;
+    ImportRejects &operator=(const ImportRejects &) = delete;
+
+    bool Open(sqlite3 *db, std::string &error);
+
+    // Removes the rows of an earlier import of the file
+    bool Clear(const std::string &fileName, std::string &error);
+
+    // An empty 'rawLine' is stored as NULL: the row's bytes are not known
+    bool Add(const std::string &fileName, size_t row, std::string_view rawLine, const std::string &reason,
+             std::string &error);
+
+private:
+    sqlite3 *m_db = nullptr;
+    sqlite3_stmt *m_add = nullptr;
+};
@@ -0,0 +1,108 @@
+#include "import_report.h"
+#include "alloc_counter.h"
+
+#include <cstdio>
+
+namespace
+{
+    std::string FormatThroughput(size_t rows, double seconds)
+    {
+        char buffer[96];
+        double rate = seconds > 0.0 ? rows / seconds : 0.0;
+        std::snprintf(buffer, sizeof(buffer), "%zu rows in %.2f s (%.0f rows/s)", rows, seconds, rate);
+        return buffer;
+    }
+
+    std::string FormatAllocations(uint64_t allocations, size_t rows)
+    {
+        char buffer[96];
+        double perRow = rows > 0 ? static_cast<double>(allocations) / rows : 0.0;
+        std::snprintf(buffer, sizeof(buffer), ", %llu allocations (%.3f per row)",
+                      static_cast<unsigned long long>(allocations), perRow);
+        return buffer;
+    }
+
+    std::string JoinNames(const std::vector<std::string> &names)
+    {
+        if (names.empty())
+            return "none";
+        std::string joined;
+        for (const std::string &name : names)
+            joined += (joined.empty() ? "" : ", ") + name;
+        return joined;
+    }
+}
+
+size_t ImportReport::TotalRows() const
+{
+    size_t rows = 0;
+    for (const TableReport &table : tables)
+        rows += table.rows;
+    return rows;
+}
+
+std::string FormatDeltaCounts(const DeltaCounts &counts)
+{
+    return std::to_string(counts.inserted) + " inserted, " + std::to_string(counts.changed) + " changed, " +
+           std::to_string(counts.deleted) + " deleted, " + std::to_string(counts.unchanged) + " unchanged";
+}
+
+std::vector<std::string> FormatImportReport(const ImportReport &report)
+{
+    std::vector<std::string> lines;
+    lines.push_back(std::string("Run report: profile ") + SessionProfileName(report.profile) + ", " +
+                    ImportModeName(report.mode) + " import, " + TableLayoutName(report.layout) + " layout");
+    lines.push_back("  Files processed: " + JoinNames(report.processedFiles));
+    if (!report.skippedFiles.empty())
+        lines.push_back("  Files skipped (unchanged): " + JoinNames(report.skippedFiles));
+    for (const TableReport &table : report.tables)
+    {
+        std::string line = "  " + table.table + ": " + FormatThroughput(table.rows, table.seconds);
+        if (AllocationCountingEnabled())
+            line += FormatAllocations(table.allocations, table.rows);
+        if (report.mode == ImportMode::Delta)
+            line += "; " + FormatDeltaCounts(table.delta);
+        if (report.quarantine)
+            line += "; " + std::to_string(table.quarantined) + " quarantined";
+        if (table.resumedAtRow > 0)
+            line += "; resumed at row " + std::to_string(table.resumedAtRow);
+        if (report.sorted)
+        {
+            char buffer[96];
+            std::snprintf(buffer, sizeof(buffer), "; sorted in %.2f s", table.sortSeconds);
+            line += buffer;
+            if (table.sortRuns > 0)
+                line += " (" + std::to_string(table.sortRuns) + (table.sortRuns == 1 ? " run" : " runs") +
+                        " spilled)";
+        }
+        lines.push_back(line);
+    }
+    if (report.foreignKeys != ForeignKeyMode::Off)
+    {
+        lines.push_back("  Foreign keys (" + std::string(ForeignKeyModeName(report.foreignKeys)) + "): " +
+                        std::to_string(report.orphanRows) + " orphan rows" +
+                        (report.foreignKeys == ForeignKeyMode::Reject && report.orphanRows ? " not inserted" : ""));
+    }
+    if (report.chunked)
+    {
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "  Transactions: %zu commits, longest %.3f s, %zu checkpoints",
+                      report.commits, report.longestTransaction, report.checkpoints);
+        lines.push_back(buffer);
+    }
+    if (report.indexSeconds > 0.0)
+    {
+        char buffer[96];
+        std::snprintf(buffer, sizeof(buffer), "  Secondary indexes and ANALYZE: %.2f s", report.indexSeconds);
+        lines.push_back(buffer);
+    }
+    if (report.databaseBytes > 0)
+    {
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "  Database file: %.1f MiB (%.1f MiB free pages)",
+                      report.databaseBytes / 1048576.0, report.freeBytes / 1048576.0);
+        lines.push_back(buffer);
+    }
+    lines.push_back("  Total: " + FormatThroughput(report.TotalRows(), report.totalSeconds));
+    return lines;
+}
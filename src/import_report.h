@@ -0,0 +1,78 @@
+// Per-run summary of an import: which profile ran and the throughput it got
+#pragma once
+
+#include "referential_check.h"
+#include "row_delta.h"
+#include "sqlite_session.h"
+#include "table_schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a delta import did with each row
+struct DeltaCounts
+{
+    size_t inserted = 0;
+    size_t changed = 0;
+    size_t deleted = 0;
+    size_t unchanged = 0;
+
+    void Add(RowChange change)
+    {
+        if (change == RowChange::Inserted)
+            inserted++;
+        else if (change == RowChange::Changed)
+            changed++;
+        else
+            unchanged++;
+    }
+};
+
+struct TableReport
+{
+    std::string table;
+    size_t rows = 0;
+    double seconds = 0.0;
+    uint64_t allocations = 0; // global operator new calls while the table was written
+    DeltaCounts delta;        // delta imports only
+    double sortSeconds = 0.0; // key-sorted imports: ranking, sorting and spilling rows
+    size_t sortRuns = 0;      // runs written to disk because the rows exceeded the sort memory
+    size_t resumedAtRow = 0;  // resumed imports: rows an interrupted run had committed
+    size_t quarantined = 0;   // quarantine imports: rows moved to ImportRejects
+};
+
+struct ImportReport
+{
+    SessionProfile profile = SessionProfile::BulkLoad;
+    ImportMode mode = ImportMode::Full;
+    TableLayout layout = TableLayout::Rowid;
+    std::vector<TableReport> tables;
+    std::vector<std::string> processedFiles;
+    std::vector<std::string> skippedFiles; // unchanged since the last import
+    double totalSeconds = 0.0;
+    ForeignKeyMode foreignKeys = ForeignKeyMode::Off;
+    size_t orphanRows = 0; // rows whose foreign keys had no parent row
+    bool quarantine = false; // rows that could not be imported went to ImportRejects
+
+    // Transactions of chunked imports: how many and how long the write lock was held
+    bool chunked = false;
+    size_t commits = 0;
+    size_t checkpoints = 0; // PASSIVE WAL checkpoints after a commit
+    double longestTransaction = 0.0;
+
+    bool sorted = false;        // rows were inserted in primary key order
+    double indexSeconds = 0.0;  // building secondary indexes and ANALYZE after the load
+    uint64_t databaseBytes = 0; // page_count * page_size after the import
+    uint64_t freeBytes = 0;     // of which on the freelist
+
+    size_t TotalRows() const;
+};
+
+// "3 inserted, 1 changed, 0 deleted, 96 unchanged"
+std::string FormatDeltaCounts(const DeltaCounts &counts);
+
+// Human-readable lines for the log or stdout. Allocation counts are listed
+// when the core was built with BAKERY_COUNT_ALLOCATIONS.
+std::vector<std::string> FormatImportReport(const ImportReport &report);
@@ -0,0 +1,931 @@
+#include "importer.h"
+
+#include "alloc_counter.h"
+#include "chunked_transaction.h"
+#include "csv_reader.h"
+#include "csv_tokenizer.h"
+#include "import_checkpoint.h"
+#include "import_manifest.h"
+#include "import_rejects.h"
+#include "key_sorter.h"
+#include "log_sink.h"
+#include "mapped_file.h"
+#include "referential_check.h"
+#include "row_delta.h"
+#include "staging_database.h"
+#include "table_binder.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    bool ExecSql(sqlite3 *db, const std::string &sql, std::string &error)
+    {
+        char *errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) == SQLITE_OK)
+            return true;
+        error = errMsg ? errMsg : "Unknown";
+        sqlite3_free(errMsg);
+        return false;
+    }
+
+    // Layout of an existing table as its CREATE statement declares it
+    TableLayout StoredLayout(sqlite3 *db, const char *table)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        std::string sql;
+        if (sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = ?", -1, &stmt,
+                               nullptr) == SQLITE_OK)
+        {
+            sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0))
+                sql = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        return sql.find("WITHOUT ROWID") != std::string::npos ? TableLayout::WithoutRowid : TableLayout::Rowid;
+    }
+
+    // A table keeps the layout it was created with; only a new database gets another one
+    template <typename Schema>
+    void CheckLayout(sqlite3 *db, TableLayout layout)
+    {
+        TableLayout actual = StoredLayout(db, Schema::kName);
+        if (Schema::kWithoutRowid && actual != layout)
+            AddLogMessage("WARNING: " + std::string(Schema::kName) + " already exists as a " +
+                          TableLayoutName(actual) + " table and keeps that layout");
+    }
+
+    // Create database tables
+    bool CreateTables(sqlite3 *db, TableLayout layout)
+    {
+        std::string createSQL = CreateTableSql<MatlistSchema>(layout) +
+                                CreateTableSql<RecipeHeadSchema>(layout) +
+                                CreateTableSql<RecipeLineSchema>(layout);
+
+        char *errMsg = nullptr;
+        int rc = sqlite3_exec(db, createSQL.c_str(), nullptr, nullptr, &errMsg);
+
+        if (rc != SQLITE_OK)
+        {
+            AddLogMessage("ERROR: Failed to create tables: " + std::string(errMsg ? errMsg : "Unknown"));
+            if (errMsg)
+                sqlite3_free(errMsg);
+            return false;
+        }
+
+        AddLogMessage("SUCCESS: Database tables created");
+        CheckLayout<MatlistSchema>(db, layout);
+        CheckLayout<RecipeLineSchema>(db, layout);
+        return true;
+    }
+
+    // Secondary indexes are filled in one sorted pass each once the tables are
+    // loaded, then ANALYZE gives the planner statistics for them
+    bool BuildIndexes(sqlite3 *db, ImportReport &report)
+    {
+        auto started = std::chrono::steady_clock::now();
+        std::string error;
+        if (!ExecSql(db,
+                     CreateIndexSql<MatlistSchema>() + CreateIndexSql<RecipeHeadSchema>() +
+                         CreateIndexSql<RecipeLineSchema>() + "ANALYZE;\n",
+                     error))
+        {
+            AddLogMessage("ERROR: Failed to build indexes: " + error);
+            return false;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        report.indexSeconds = elapsed.count();
+        return true;
+    }
+
+    // Chunk limits of an online import unless the options set their own
+    constexpr size_t kOnlineCommitRows = 20000;
+    constexpr double kOnlineCommitSeconds = 0.25;
+
+    // Chunk limits of a resumable import unless the options set their own
+    constexpr size_t kResumeCommitRows = 100000;
+    constexpr double kResumeCommitSeconds = 5.0;
+
+    // State shared by the per-table steps of one import
+    struct ImportContext
+    {
+        sqlite3 *db;
+        const ImportOptions &options;
+        ImportProgress &progress;
+        ImportReport &report;
+        ImportManifest &manifest;
+        ImportCheckpoints &checkpoints;
+        ImportRejects *rejects = nullptr; // quarantine imports only
+        KeyDictionaries keys{}; // recipe and material numbers, shared by all files
+        KeySets parents{};      // ids present in Matlist and RecipeHead
+        OrphanReport orphans{};
+        bool checkKeys = false; // RecipeLine is imported and its keys are checked
+        size_t commitRows = 0;     // chunk limits for each table's transaction; 0 = none
+        double commitSeconds = 0.0;
+        bool sortByKey = false;
+        bool deletesPending = false; // the last delta table deleted no removed rows
+        std::string manifestSettings{};   // options that change which rows a file produces
+        std::string checkpointSettings{}; // the same plus the import mode
+        std::string sortSpillPath{};      // sort runs go to "<this>.<table>-sort.<n>"
+    };
+
+    // One CSV file of the import and whether this run reads it
+    struct SourceFile
+    {
+        std::string name;
+        std::string path;
+        FileFingerprint fingerprint{};
+        bool skip = false;    // unchanged since it was last imported
+        bool opened = false;  // its reader was started
+        bool resumed = false; // an interrupted import of it continues at 'resume'
+        ResumePoint resume{};
+    };
+
+    bool TableHasRows(sqlite3 *db, const char *table)
+    {
+        std::string sql = std::string("SELECT EXISTS (SELECT 1 FROM ") + table + ")";
+        sqlite3_stmt *stmt = nullptr;
+        bool hasRows = false;
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+            hasRows = sqlite3_column_int(stmt, 0) != 0;
+        sqlite3_finalize(stmt);
+        return hasRows;
+    }
+
+    // Checks a row's foreign keys against the parent key sets; reports and returns true for an orphan.
+    // 'reason', if given, receives what is missing.
+    template <typename Schema>
+    bool IsOrphan(ImportContext &context, const RowBatch &batch, size_t row, std::string *reason = nullptr)
+    {
+        bool orphan = false;
+        for (const ForeignKeyDesc &foreignKey : Schema::kForeignKeys)
+        {
+            const BatchColumn &column = batch.columns[foreignKey.column];
+            if (!context.parents.For(column.key)->Contains(column.keys[row]))
+            {
+                const char *name = Schema::kColumns[foreignKey.column].name;
+                std::string_view value = batch.Text(foreignKey.column, row);
+                context.orphans.Add(Schema::kName, batch.firstRow + row, name, value);
+                if (reason)
+                    *reason += (reason->empty() ? "" : "; ") + std::string(name) + " " + std::string(value) +
+                               " has no " + foreignKey.parentTable + " row";
+                orphan = true;
+            }
+        }
+        return orphan;
+    }
+
+    // Failures that concern only the row: SQLite has undone the one statement
+    // and the transaction is still open, so the import can go on without it
+    bool IsRowFailure(sqlite3 *db, int code)
+    {
+        bool rowCode = code == SQLITE_CONSTRAINT || code == SQLITE_MISMATCH || code == SQLITE_TOOBIG ||
+                       code == SQLITE_RANGE;
+        return rowCode && !sqlite3_get_autocommit(db);
+    }
+
+    // The row's line in the file without line breaks; empty for rows decoded from sort runs
+    std::string_view RawLine(std::string_view text, const RowBatch &batch, size_t row)
+    {
+        if (row >= batch.rowEnds.size())
+            return {};
+        size_t begin = row == 0 ? batch.startOffset : batch.rowEnds[row - 1];
+        size_t end = batch.rowEnds[row];
+        while (begin < end && (text[begin] == '\r' || text[begin] == '\n'))
+            begin++;
+        while (end > begin && (text[end - 1] == '\r' || text[end - 1] == '\n'))
+            end--;
+        return text.substr(begin, end - begin);
+    }
+
+    // Import one table from its CSV through the schema's prepared INSERT. Rows
+    // are screened in file order: parse errors end the import and orphans are
+    // reported or dropped. With sortByKey the remaining rows are written in
+    // primary key order once the file is read, otherwise as they arrive. In
+    // delta mode only rows whose content hash differs from the stored one are
+    // written, and rows whose key no longer appears are deleted.
+    //
+    // A quarantine import moves rows that do not parse, rejected orphans and
+    // rows whose INSERT fails to ImportRejects and goes on. Each row is its
+    // own statement, so a failed one is already undone by SQLite; the rows
+    // that do insert pay nothing for this.
+    //
+    // Rows written in file order can be resumed: each chunk's commit saves the
+    // position after its last row as the file's checkpoint, and the final
+    // commit removes it.
+    template <typename Schema>
+    bool InsertTable(ImportContext &context, CsvBatchReader &reader, const SourceFile &file, ImportPhase phase,
+                     const char *what)
+    {
+        auto started = std::chrono::steady_clock::now();
+        uint64_t allocationsBefore = AllocationCount();
+        constexpr size_t colCount = ColumnCount<Schema>();
+        const std::string table = Schema::kName;
+        sqlite3 *db = context.db;
+        const bool checkKeys = context.options.foreignKeys != ForeignKeyMode::Off;
+        const bool rejectOrphans = context.options.foreignKeys == ForeignKeyMode::Reject;
+        const bool delta = context.options.mode == ImportMode::Delta;
+        ImportRejects *rejects = context.rejects;
+
+        PreparedInsert insert;
+        if (!insert.Prepare(db, table, colCount))
+        {
+            reader.Cancel();
+            AddLogMessage("ERROR: Failed to prepare " + table + " insert: " + std::string(sqlite3_errmsg(db)));
+            return false;
+        }
+
+        std::unique_ptr<KeySorter> sorter;
+        if (context.sortByKey)
+            sorter = MakeKeySorter<Schema>(context.keys, context.options.sortMemoryBytes,
+                                           context.sortSpillPath + "." + table + "-sort");
+
+        context.progress.BeginPhase(phase, reader.FileSize());
+        ChunkedTransaction transaction(db, context.commitRows, context.commitSeconds,
+                                       context.options.profile == SessionProfile::Online);
+        std::string transactionError;
+        if (!transaction.Begin(transactionError))
+        {
+            reader.Cancel();
+            AddLogMessage("ERROR: Failed to start the " + table + " transaction: " + transactionError);
+            return false;
+        }
+
+        // Rewritten rows would make the table's stored hashes stale for the next delta import
+        if (!delta && !ClearRowHashes(db, Schema::kName, transactionError))
+        {
+            reader.Cancel();
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to clear the " + table + " row hashes: " + transactionError);
+            return false;
+        }
+
+        RowHashStore hashes;
+        std::string hashError;
+        if (delta && !hashes.Load(db, Schema::kName, PrimaryKeyList<Schema>(), ColumnList<Schema>(), hashError))
+        {
+            reader.Cancel();
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to read " + table + " row hashes: " + hashError);
+            return false;
+        }
+        if (hashes.Seeded() > 0)
+            AddLogMessage(table + " has no row hashes from a delta import yet; hashed its " +
+                          std::to_string(hashes.Seeded()) + " stored rows");
+
+        // A file imported from the start replaces the rows its last import quarantined
+        if (rejects && !file.resumed && !rejects->Clear(file.name, transactionError))
+        {
+            reader.Cancel();
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to clear the quarantined " + table + " rows: " + transactionError);
+            return false;
+        }
+
+        ResumePoint position = file.resume; // just past the last row taken from the reader
+        size_t savedRows = 0;
+        PrefixHasher prefix(reader.FileText());
+        if (!sorter)
+        {
+            transaction.SetCommitHook([&](std::string &error) {
+                position.prefixHash = prefix.Hash(position.byteOffset);
+                savedRows = position.rowNumber;
+                return context.checkpoints.Save(file.name, context.checkpointSettings, position, error);
+            });
+        }
+
+        auto fail = [&](const std::string &message) {
+            reader.Cancel();
+            transaction.Rollback();
+            AddLogMessage("ERROR: " + message);
+            if (transaction.Commits() > 0 && !sorter)
+                AddLogMessage(file.name + " is committed up to row " + std::to_string(savedRows) +
+                              "; an import with resume continues from there");
+            return false;
+        };
+
+        size_t accepted = 0;
+        size_t quarantined = 0;
+        DeltaCounts counts;
+        auto quarantineRow = [&](const RowBatch &batch, size_t batchRow, size_t fileRow, const std::string &reason) {
+            std::string error;
+            if (!rejects->Add(file.name, fileRow, RawLine(reader.FileText(), batch, batchRow), reason, error) ||
+                !transaction.RowDone(error))
+                return fail("Failed to quarantine " + table + " row " + std::to_string(fileRow) + ": " + error);
+            quarantined++;
+            return true;
+        };
+
+        auto writeRow = [&](const RowBatch &batch, size_t batchRow, size_t fileRow) {
+            std::string error;
+            RowChange change = RowChange::Inserted;
+            uint64_t keyHash = 0;
+            uint64_t rowHash = 0;
+            if (delta)
+            {
+                keyHash = RowKeyHash<Schema>(batch, batchRow);
+                rowHash = RowContentHash<Schema>(batch, batchRow);
+                change = hashes.Classify(keyHash, rowHash);
+            }
+
+            // The hash is stored after the row, so a quarantined row keeps the old one
+            if (change != RowChange::Unchanged && (!BindRow<Schema>(insert, batch, batchRow) || !insert.Execute()))
+            {
+                if (rejects && IsRowFailure(db, insert.ErrorCode()))
+                    return quarantineRow(batch, batchRow, fileRow, insert.ErrorMessage());
+                error = insert.ErrorMessage();
+            }
+            else if (change != RowChange::Unchanged && delta && !hashes.Record(keyHash, rowHash))
+            {
+                error = sqlite3_errmsg(db);
+            }
+            else
+            {
+                transaction.RowDone(error);
+            }
+
+            if (!error.empty())
+                return fail("Failed to insert " + table + " row " + std::to_string(fileRow) + ": " + error);
+            accepted++;
+            counts.Add(change);
+            return true;
+        };
+
+        // A delta import deletes the stored rows whose key it did not see; a
+        // quarantined row whose key is unknown stops that for this import
+        bool keysUnknown = false;
+
+        RowBatchPtr next;
+        std::string sortError;
+        while (reader.Next(next))
+        {
+            const RowBatch &batch = *next;
+            size_t nextError = 0;
+            for (size_t batchRow = 0; batchRow < batch.rowCount; batchRow++)
+            {
+                const size_t fileRow = batch.firstRow + batchRow;
+                // Written, rejected or quarantined, the row is behind the next checkpoint
+                position.byteOffset = batch.rowEnds[batchRow];
+                position.rowNumber = fileRow + 1;
+
+                if (nextError < batch.errors.size() && batch.errors[nextError].row == batchRow)
+                {
+                    const RowError &rowError = batch.errors[nextError++];
+                    if (!rejects)
+                        return fail("Failed to insert " + table + " row " + std::to_string(fileRow) + ": " +
+                                    rowError.message);
+                    if (delta)
+                    {
+                        // Cells before the failing one were parsed; a key among them keeps its stored row
+                        bool keyParsed = std::all_of(Schema::kPrimaryKey.begin(), Schema::kPrimaryKey.end(),
+                                                     [&](size_t column) { return column < rowError.column; });
+                        if (keyParsed)
+                            hashes.Classify(RowKeyHash<Schema>(batch, batchRow), 0);
+                        else
+                            keysUnknown = true;
+                    }
+                    if (!quarantineRow(batch, batchRow, fileRow, rowError.message))
+                        return false;
+                    continue;
+                }
+
+                std::string orphanReason;
+                if (checkKeys && IsOrphan<Schema>(context, batch, batchRow, rejects ? &orphanReason : nullptr) &&
+                    rejectOrphans)
+                {
+                    if (rejects && !quarantineRow(batch, batchRow, fileRow, orphanReason))
+                        return false;
+                    continue;
+                }
+
+                if constexpr (Schema::kKeyColumn >= 0)
+                {
+                    const BatchColumn &key = batch.columns[Schema::kKeyColumn];
+                    context.parents.For(key.key)->Insert(key.keys[batchRow]);
+                }
+
+                if (sorter)
+                    sorter->Add(batch, batchRow);
+                else if (!writeRow(batch, batchRow, fileRow))
+                    return false;
+            }
+
+            context.progress.AddRows(phase, batch.rowCount);
+            context.progress.SetBytes(phase, batch.endOffset);
+            if (sorter && !sorter->Take(std::move(next), sortError))
+                return fail("Failed to sort " + table + ": " + sortError);
+        }
+
+        if (reader.Failed())
+        {
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to read " + table + " CSV: " + reader.Error());
+            return false;
+        }
+
+        if (sorter)
+        {
+            if (!sorter->Finish(sortError))
+                return fail("Failed to sort " + table + ": " + sortError);
+            const RowBatch *sortedBatch = nullptr;
+            size_t sortedRow = 0;
+            size_t fileRow = 0;
+            while (sorter->Next(sortedBatch, sortedRow, fileRow))
+            {
+                if (!writeRow(*sortedBatch, sortedRow, fileRow))
+                    return false;
+            }
+            if (sorter->Failed())
+                return fail("Failed to sort " + table + ": " + sorter->Error());
+        }
+
+        // A resumed file has not seen the rows before its checkpoint
+        context.deletesPending = delta && (file.resumed || keysUnknown);
+        if (delta && keysUnknown)
+            AddLogMessage("Removed " + table + " rows are deleted by the next delta import: a quarantined row's key "
+                          "did not parse");
+        if (delta && !context.deletesPending &&
+            !hashes.DeleteUnseen(PrimaryKeyList<Schema>(), counts.deleted, hashError))
+        {
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to delete removed " + table + " rows: " + hashError);
+            return false;
+        }
+
+        transaction.SetCommitHook(
+            [&](std::string &error) { return context.checkpoints.Clear(file.name, error); });
+        if (!transaction.Commit(transactionError))
+        {
+            transaction.Rollback();
+            AddLogMessage("ERROR: Failed to commit " + table + ": " + transactionError);
+            return false;
+        }
+        context.report.commits += transaction.Commits();
+        context.report.checkpoints += transaction.Checkpoints();
+        context.report.longestTransaction = std::max(context.report.longestTransaction, transaction.LongestSeconds());
+        if (delta)
+            AddLogMessage("SUCCESS: Imported " + std::to_string(accepted) + " " + what + " (" +
+                          FormatDeltaCounts(counts) + ")");
+        else
+            AddLogMessage("SUCCESS: Imported " + std::to_string(accepted) + " " + what);
+        if (quarantined > 0)
+            AddLogMessage("WARNING: " + std::to_string(quarantined) + " rows of " + file.name +
+                          " were quarantined in ImportRejects");
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        context.report.tables.push_back(
+            {table, accepted, elapsed.count(), AllocationCount() - allocationsBefore, counts});
+        context.report.tables.back().quarantined = quarantined;
+        if (file.resumed)
+            context.report.tables.back().resumedAtRow = file.resume.rowNumber;
+        if (sorter)
+        {
+            context.report.tables.back().sortSeconds = sorter->SortSeconds();
+            context.report.tables.back().sortRuns = sorter->Runs();
+        }
+        return true;
+    }
+
+    // Inserts one table if its file was opened and records the file in the
+    // manifest. For a parent table, keys already in the database count as
+    // present too, so they are read back when the table had rows before the
+    // import or its file was skipped.
+    template <typename Schema>
+    bool ImportTable(ImportContext &context, CsvBatchReader &reader, const SourceFile &file, ImportPhase phase,
+                     const char *what)
+    {
+        constexpr bool isParent = Schema::kKeyColumn >= 0;
+        const bool checkKeys = context.checkKeys;
+        const bool opened = file.opened;
+        bool hadRows = isParent && checkKeys && opened && TableHasRows(context.db, Schema::kName);
+
+        context.deletesPending = false;
+        if (opened && !InsertTable<Schema>(context, reader, file, phase, what))
+            return false;
+
+        // A delta import that deleted nothing leaves that to the next one, which must read the whole file
+        std::string manifestError;
+        if (opened && !context.deletesPending && file.fingerprint.hashed &&
+            !context.manifest.Record(file.name, file.fingerprint, context.manifestSettings, manifestError))
+            AddLogMessage("WARNING: " + file.name + " not recorded in the import manifest: " + manifestError);
+
+        if constexpr (isParent)
+        {
+            if (checkKeys && (hadRows || !opened))
+            {
+                const ColumnDesc &column = Schema::kColumns[Schema::kKeyColumn];
+                std::string error;
+                if (!LoadExistingKeys(context.db, Schema::kName, column.name, *context.keys.For(column.key),
+                                      *context.parents.For(column.key), error))
+                {
+                    AddLogMessage("ERROR: Cannot read existing " + std::string(Schema::kName) + " keys: " + error);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint64_t PragmaInteger(sqlite3 *db, const char *pragma)
+    {
+        std::string sql = std::string("PRAGMA ") + pragma;
+        sqlite3_stmt *stmt = nullptr;
+        uint64_t value = 0;
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+            value = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        sqlite3_finalize(stmt);
+        return value;
+    }
+
+    std::string FormatSeconds(double seconds)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f s", seconds);
+        return buffer;
+    }
+
+    // Looks for the checkpoint of an interrupted import of the file. With
+    // 'resume' the file continues from it if it was written under the same
+    // settings and the file's bytes up to it are unchanged. Returns true if
+    // there is a checkpoint; the file's table then holds part of some version
+    // of it.
+    bool FindResumePoint(ImportContext &context, SourceFile &file, bool resume)
+    {
+        ResumePoint point;
+        std::string settings;
+        std::string error;
+        bool found = false;
+        if (!context.checkpoints.Find(file.name, point, settings, found, error))
+        {
+            AddLogMessage("WARNING: Cannot read the checkpoint of " + file.name + ": " + error);
+            return false;
+        }
+        if (!found)
+            return false;
+
+        std::string interrupted = file.name + " was interrupted at row " + std::to_string(point.rowNumber);
+        if (!resume)
+        {
+            AddLogMessage(interrupted + "; importing it from the start (resume is off)");
+            return true;
+        }
+        if (settings != context.checkpointSettings)
+        {
+            AddLogMessage(interrupted + " of a " + settings + " import; importing it from the start");
+            return true;
+        }
+
+        MappedFile text;
+        if (!text.Open(file.path) || text.Size() < point.byteOffset ||
+            PrefixHasher(text.View()).Hash(point.byteOffset) != point.prefixHash)
+        {
+            AddLogMessage(interrupted + ", but has changed since; importing it from the start");
+            return true;
+        }
+
+        file.resume = point;
+        file.resumed = true;
+        AddLogMessage("Resuming " + file.name + " at row " + std::to_string(point.rowNumber) + " (byte " +
+                      std::to_string(point.byteOffset) + " of " + std::to_string(text.Size()) + ")");
+        if (context.options.mode == ImportMode::Delta)
+            AddLogMessage(file.name + ": rows removed from the file are deleted by the next delta import");
+        return true;
+    }
+
+    // Start parsing a CSV in the background; logs and returns false if it cannot be opened
+    bool StartCsvReader(CsvBatchReader &reader, const SourceFile &file)
+    {
+        bool started = file.resumed ? reader.Start(file.path, file.resume.byteOffset, file.resume.rowNumber)
+                                    : reader.Start(file.path);
+        if (!started)
+        {
+            AddLogMessage("ERROR: Cannot open file: " + file.path + " (" + reader.Error() + ")");
+            return false;
+        }
+        AddLogMessage("Reading " + file.name + " (" + std::to_string(reader.Threads()) + " parser threads)...");
+        return true;
+    }
+}
+
+bool RunImport(const ImportOptions &options, ImportProgress &progress, ImportReport &report)
+{
+    progress.Reset();
+    progress.BeginPhase(ImportPhase::Preparing);
+
+    AddLogMessage("Starting import process...");
+
+    if (options.csvFolder.empty())
+    {
+        AddLogMessage("ERROR: Please select CSV folder");
+        return false;
+    }
+
+    std::string dbPath = options.dbPath.empty() ? "bakery.db" : options.dbPath;
+
+    // Check CSV files exist
+    fs::path folder(options.csvFolder);
+    std::string matlistPath = (folder / "Matlist.csv").string();
+    std::string recipeHeadPath = (folder / "Recipehead.csv").string();
+    std::string recipeLinePath = (folder / "Recipeline.csv").string();
+
+    if (!fs::exists(matlistPath) || !fs::exists(recipeHeadPath) || !fs::exists(recipeLinePath))
+    {
+        AddLogMessage("ERROR: Required CSV files not found in folder");
+        return false;
+    }
+
+    AddLogMessage("All CSV files found");
+    AddLogMessage(std::string("CSV tokenizer: ") + TokenizerKernelName(ActiveTokenizerKernel()));
+
+    // The staging profile builds a copy next to the target and swaps it in at the end
+    StagingDatabase staging;
+    std::string openPath = dbPath;
+    if (options.profile == SessionProfile::Staging)
+    {
+        auto seedStarted = std::chrono::steady_clock::now();
+        std::string stagingError;
+        if (!staging.Create(dbPath, stagingError))
+        {
+            AddLogMessage("ERROR: Cannot create the staging database: " + stagingError);
+            return false;
+        }
+        openPath = staging.Path();
+        std::chrono::duration<double> seeded = std::chrono::steady_clock::now() - seedStarted;
+        AddLogMessage("Staging database: " + openPath + " (copied from the target in " +
+                      FormatSeconds(seeded.count()) + ")");
+    }
+
+    // Open database
+    sqlite3 *db;
+    if (sqlite3_open(openPath.c_str(), &db))
+    {
+        AddLogMessage("ERROR: Cannot open database: " + std::string(sqlite3_errmsg(db)));
+        sqlite3_close(db);
+        return false;
+    }
+
+    AddLogMessage("Database opened: " + openPath);
+
+    // Apply the session profile for the duration of the import
+    SessionSettings session;
+    std::string sessionError;
+    if (!session.Apply(db, options.profile, sessionError))
+    {
+        AddLogMessage("ERROR: Cannot apply " + std::string(SessionProfileName(options.profile)) +
+                      " profile: " + sessionError);
+        sqlite3_close(db);
+        return false;
+    }
+    AddLogMessage("Session profile: " + std::string(SessionProfileName(options.profile)));
+
+    report.profile = options.profile;
+    auto importStarted = std::chrono::steady_clock::now();
+
+    // Create tables
+    if (!CreateTables(db, options.layout))
+    {
+        session.Restore();
+        sqlite3_close(db);
+        return false;
+    }
+
+    // A delta import compares against the stored row hashes. A full import
+    // clears those of each table it rewrites, in that table's transaction.
+    std::string hashError;
+    if (options.mode == ImportMode::Delta && !PrepareRowHashes(db, hashError))
+    {
+        AddLogMessage("ERROR: Cannot prepare row hashes: " + hashError);
+        session.Restore();
+        sqlite3_close(db);
+        return false;
+    }
+    report.mode = options.mode;
+
+    ImportManifest manifest;
+    std::string manifestError;
+    if (!manifest.Open(db, manifestError))
+    {
+        AddLogMessage("ERROR: Cannot open the import manifest: " + manifestError);
+        session.Restore();
+        sqlite3_close(db);
+        return false;
+    }
+
+    ImportCheckpoints checkpoints;
+    std::string checkpointError;
+    if (!checkpoints.Open(db, checkpointError))
+    {
+        AddLogMessage("ERROR: Cannot open the import checkpoints: " + checkpointError);
+        session.Restore();
+        sqlite3_close(db);
+        return false;
+    }
+
+    // Quarantine rolls back the failed row's statement, which needs a rollback
+    // journal; the staging profile runs without one
+    bool quarantine = options.quarantine;
+    if (quarantine && options.profile == SessionProfile::Staging)
+    {
+        AddLogMessage("WARNING: Quarantine is off with the staging profile; a bad row fails the import and leaves "
+                      "the target unchanged");
+        quarantine = false;
+    }
+    ImportRejects rejects;
+    std::string rejectsError;
+    if (quarantine && !rejects.Open(db, rejectsError))
+    {
+        AddLogMessage("ERROR: Cannot open the ImportRejects table: " + rejectsError);
+        session.Restore();
+        sqlite3_close(db);
+        return false;
+    }
+
+    bool success = false;
+    try
+    {
+        ImportContext context{db, options, progress, report, manifest, checkpoints};
+        if (quarantine)
+        {
+            context.rejects = &rejects;
+            AddLogMessage("Quarantine: rows that cannot be imported go to the ImportRejects table");
+        }
+        report.quarantine = quarantine;
+        context.commitRows = options.commitRows;
+        context.commitSeconds = options.commitSeconds;
+        const bool defaultChunks = options.commitRows == 0 && options.commitSeconds <= 0.0;
+        if (options.profile == SessionProfile::Online && defaultChunks)
+        {
+            context.commitRows = kOnlineCommitRows;
+            context.commitSeconds = kOnlineCommitSeconds;
+        }
+
+        // The staging file of an interrupted import is thrown away, and with it its checkpoints
+        bool resume = options.resume;
+        if (resume && options.profile == SessionProfile::Staging)
+        {
+            AddLogMessage("WARNING: Resume is off with the staging profile; an interrupted import leaves the target "
+                          "unchanged");
+            resume = false;
+        }
+        if (resume && options.profile == SessionProfile::BulkLoad)
+            AddLogMessage("WARNING: The bulk-load profile keeps its journal in memory; a crash can corrupt the "
+                          "database. Use the safe or online profile for a crash-safe resume.");
+        if (resume && defaultChunks && options.profile != SessionProfile::Online)
+        {
+            context.commitRows = kResumeCommitRows;
+            context.commitSeconds = kResumeCommitSeconds;
+        }
+        context.sortByKey = options.sortByKey;
+        if (resume && options.sortByKey)
+        {
+            AddLogMessage("Rows are not sorted: a resumable import commits them in file order");
+            context.sortByKey = false;
+        }
+
+        report.chunked = context.commitRows != 0 || context.commitSeconds > 0.0;
+        report.sorted = context.sortByKey;
+        report.layout = StoredLayout(db, RecipeLineSchema::kName);
+        context.sortSpillPath = openPath;
+        if (context.sortByKey)
+            AddLogMessage("Rows are sorted by primary key before insert (" +
+                          std::to_string(options.sortMemoryBytes >> 20) + " MiB in memory per table)");
+        report.foreignKeys = options.foreignKeys;
+        std::string orphanError;
+        if (!options.orphanReportPath.empty() && !context.orphans.Open(options.orphanReportPath, orphanError))
+            AddLogMessage("WARNING: Orphan report not written: " + orphanError);
+
+        // Rejected orphans depend on the parent tables as well as on the file
+        context.manifestSettings = options.foreignKeys == ForeignKeyMode::Reject ? "reject-orphans" : "";
+        context.checkpointSettings = std::string(ImportModeName(options.mode)) +
+                                     (context.manifestSettings.empty() ? "" : ", " + context.manifestSettings);
+        SourceFile matlist{"Matlist.csv", matlistPath};
+        SourceFile recipeHead{"Recipehead.csv", recipeHeadPath};
+        SourceFile recipeLine{"Recipeline.csv", recipeLinePath};
+        for (SourceFile *file : {&matlist, &recipeHead, &recipeLine})
+        {
+            // An interrupted file is read even if the manifest lists it: its table
+            // holds part of a version that may not be the one listed
+            manifestError.clear();
+            bool interrupted = FindResumePoint(context, *file, resume);
+            if (options.forceImport || interrupted)
+                FingerprintFile(file->path, file->fingerprint, manifestError);
+            else
+                file->skip = context.manifest.IsUnchanged(file->name, file->path, context.manifestSettings,
+                                                          file->fingerprint, manifestError);
+            if (!manifestError.empty())
+                AddLogMessage("WARNING: Cannot check " + file->name + " against the import manifest: " + manifestError);
+        }
+        if (recipeLine.skip && options.foreignKeys == ForeignKeyMode::Reject && !(matlist.skip && recipeHead.skip))
+        {
+            AddLogMessage("Recipeline.csv is unchanged, but is read again because its parent files changed");
+            recipeLine.skip = false;
+        }
+        context.checkKeys = options.foreignKeys != ForeignKeyMode::Off && !recipeLine.skip;
+
+        // All three files parse at once; this thread is the only writer and takes
+        // them in dependency order. The later files fill their deeper queues
+        // while the earlier tables are inserted.
+        CsvBatchReader matlistReader(ColumnsOf<MatlistSchema>(), options.batchRows, options.queueDepth,
+                                     options.parseThreads, &context.keys);
+        CsvBatchReader recipeHeadReader(ColumnsOf<RecipeHeadSchema>(), options.batchRows, options.readAheadDepth,
+                                        options.parseThreads, &context.keys);
+        CsvBatchReader recipeLineReader(ColumnsOf<RecipeLineSchema>(), options.batchRows, options.readAheadDepth,
+                                        options.parseThreads, &context.keys);
+        for (auto [file, reader] : {std::pair{&matlist, &matlistReader}, std::pair{&recipeHead, &recipeHeadReader},
+                                    std::pair{&recipeLine, &recipeLineReader}})
+        {
+            if (file->skip)
+            {
+                AddLogMessage(file->name + " is unchanged since it was last imported; skipped");
+                report.skippedFiles.push_back(file->name);
+            }
+            else
+            {
+                file->opened = StartCsvReader(*reader, *file);
+                if (file->opened)
+                    report.processedFiles.push_back(file->name);
+            }
+        }
+
+        // A full import that builds secondary indexes drops those of the tables
+        // it rewrites rather than updating them row by row. A delta import
+        // writes few rows, and an online import keeps them for its readers.
+        std::string dropIndexes;
+        if (options.secondaryIndexes && options.mode == ImportMode::Full &&
+            options.profile != SessionProfile::Online)
+        {
+            if (matlist.opened)
+                dropIndexes += DropIndexSql<MatlistSchema>();
+            if (recipeHead.opened)
+                dropIndexes += DropIndexSql<RecipeHeadSchema>();
+            if (recipeLine.opened)
+                dropIndexes += DropIndexSql<RecipeLineSchema>();
+        }
+        std::string indexError;
+        if (!dropIndexes.empty() && !ExecSql(db, dropIndexes, indexError))
+            AddLogMessage("WARNING: Secondary indexes are updated during the load: " + indexError);
+
+        // A file that cannot be opened is logged and skipped
+        bool ok = ImportTable<MatlistSchema>(context, matlistReader, matlist, ImportPhase::Matlist, "materials") &&
+                  ImportTable<RecipeHeadSchema>(context, recipeHeadReader, recipeHead, ImportPhase::RecipeHead,
+                                                "recipes") &&
+                  ImportTable<RecipeLineSchema>(context, recipeLineReader, recipeLine, ImportPhase::RecipeLine,
+                                                "recipe lines");
+        // Also after a failed table, so that the tables rolled back to their old rows get their indexes back
+        if (options.secondaryIndexes && !report.processedFiles.empty())
+            ok = BuildIndexes(db, report) && ok;
+        report.orphanRows = context.orphans.Count();
+        context.orphans.Close();
+
+        if (ok)
+        {
+            progress.Finish();
+            AddLogMessage("Key dictionaries: " + std::to_string(context.keys.recipes.Size()) + " recipe numbers, " +
+                          std::to_string(context.keys.materials.Size()) + " material numbers");
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - importStarted;
+            report.totalSeconds = elapsed.count();
+            uint64_t pageSize = PragmaInteger(db, "page_size");
+            report.databaseBytes = PragmaInteger(db, "page_count") * pageSize;
+            report.freeBytes = PragmaInteger(db, "freelist_count") * pageSize;
+            for (const std::string &line : FormatImportReport(report))
+                AddLogMessage(line);
+            success = true;
+        }
+    }
+    catch (...)
+    {
+        AddLogMessage("ERROR: Exception during import");
+    }
+
+    session.Restore();
+    sqlite3_close(db);
+
+    if (success && options.profile == SessionProfile::Staging)
+    {
+        auto publishStarted = std::chrono::steady_clock::now();
+        std::string method;
+        std::string stagingError;
+        success = staging.Publish(method, stagingError);
+        std::chrono::duration<double> published = std::chrono::steady_clock::now() - publishStarted;
+        if (success)
+            AddLogMessage("Staging database " + method + " in " + FormatSeconds(published.count()));
+        else
+            AddLogMessage("ERROR: Cannot replace " + dbPath + " with the staging database: " + stagingError);
+    }
+
+    if (success)
+    {
+        AddLogMessage("SUCCESS: Import completed successfully!");
+        AddLogMessage("Database saved to: " + dbPath);
+    }
+    return success;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+// The import itself, shared by the Win32 window and the command-line front-end
+#pragma once
+
+#include "import_progress.h"
+#include "import_report.h"
+#include "referential_check.h"
+#include "row_delta.h"
+#include "sqlite_session.h"
+#include "table_schema.h"
+
+#include <cstddef>
+#include <string>
+
+struct ImportOptions
+{
+    std::string csvFolder; // holds Matlist.csv, Recipehead.csv and Recipeline.csv
+    std::string dbPath = "bakery.db";
+    SessionProfile profile = SessionProfile::BulkLoad;
+    TableLayout layout = TableLayout::Rowid; // for tables the import creates
+
+    // Build the schemas' secondary indexes (RecipeLine by MatItemNr, for
+    // where-used queries) and run ANALYZE after the load. A full import drops
+    // them first and rebuilds them in one pass, which costs about 2 s per
+    // million recipe lines and some 15 MiB of file. Off by default, like the
+    // original import; indexes created by an earlier run are then left in
+    // place and kept up to date row by row.
+    bool secondaryIndexes = false;
+    ImportMode mode = ImportMode::Full;
+    bool forceImport = false; // also import files the manifest says are unchanged
+
+    // Streaming parameters: at most queueDepth batches of batchRows rows in flight
+    // for the file being written. Files that parse while an earlier table is
+    // still being written may run readAheadDepth batches ahead.
+    size_t batchRows = 4096;
+    size_t queueDepth = 4;
+    size_t readAheadDepth = 16;
+
+    // Parser threads per file; 0 uses one per hardware thread
+    size_t parseThreads = 0;
+
+    // Each table is written in transactions of at most commitRows rows and
+    // commitSeconds; 0 means no limit. With both 0 the online profile uses
+    // 20000 rows and 0.25 s, the others one transaction per table.
+    size_t commitRows = 0;
+    double commitSeconds = 0.0;
+
+    // Every commit records in the database how far its file got. With resume,
+    // a file whose import was interrupted continues after its last committed
+    // chunk, unless the bytes before that point have changed. Without commit
+    // limits a resumable import commits every 100000 rows or 5 s. Crash-safe
+    // with the safe and online profiles, whose journals are on disk.
+    bool resume = false;
+
+    // Rows are sorted by primary key before they are inserted, so each table is
+    // built by appending to its B-tree. A table whose parsed rows take more
+    // than sortMemoryBytes is sorted in runs on disk and merged.
+    bool sortByKey = false;
+    size_t sortMemoryBytes = size_t(256) << 20;
+
+    // Rows that do not parse, that the database refuses or that are rejected
+    // orphans go to the ImportRejects table instead of failing their table
+    bool quarantine = false;
+
+    // RecipeLine keys are checked against Matlist and RecipeHead before insert
+    ForeignKeyMode foreignKeys = ForeignKeyMode::Report;
+    std::string orphanReportPath; // optional file listing every orphan row
+};
+
+// Imports the three CSV files into the database. Messages go to AddLogMessage,
+// counters to 'progress'; 'report' is filled for every table that committed.
+// Returns true if all three tables were imported.
+bool RunImport(const ImportOptions &options, ImportProgress &progress, ImportReport &report);
@@ -0,0 +1,48 @@
+#include "key_dictionary.h"
+
+uint32_t KeyDictionary::InternLocked(std::string_view value)
+{
+    auto found = m_ids.find(value);
+    if (found != m_ids.end())
+        return found->second;
+
+    uint32_t id = static_cast<uint32_t>(m_byId.size());
+    char *bytes = static_cast<char *>(m_memory.allocate(value.size() ? value.size() : 1, 1));
+    value.copy(bytes, value.size());
+    std::string_view stored(bytes, value.size());
+    m_byId.push_back(stored);
+    m_ids.emplace(stored, id);
+    return id;
+}
+
+void KeyDictionary::Intern(const std::string_view *values, size_t count, uint32_t *ids)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < count; i++)
+        ids[i] = InternLocked(values[i]);
+}
+
+uint32_t KeyDictionary::Intern(std::string_view value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return InternLocked(value);
+}
+
+uint32_t KeyDictionary::Find(std::string_view value) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_ids.find(value);
+    return found != m_ids.end() ? found->second : kNoKey;
+}
+
+std::string_view KeyDictionary::Value(uint32_t id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return id < m_byId.size() ? m_byId[id] : std::string_view();
+}
+
+size_t KeyDictionary::Size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byId.size();
+}
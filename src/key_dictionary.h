@@ -0,0 +1,65 @@
+// Per-import interning of recipe and material numbers into dense ids
+#pragma once
+
+#include "table_schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Id of an empty key cell
+constexpr uint32_t kNoKey = UINT32_MAX;
+
+// Maps each distinct key value to an id: 0, 1, 2, ... in order of first
+// appearance. Parsers intern into a batch-local table first and merge a
+// whole batch here at once, so the lock is taken once per batch, not per row.
+class KeyDictionary
+{
+public:
+    KeyDictionary() = default;
+    KeyDictionary(const KeyDictionary &) = delete;
+    KeyDictionary &operator=(const KeyDictionary &) = delete;
+
+    // Interns 'count' values and writes their ids to 'ids'
+    void Intern(const std::string_view *values, size_t count, uint32_t *ids);
+    uint32_t Intern(std::string_view value);
+
+    // kNoKey if the value was never interned
+    uint32_t Find(std::string_view value) const;
+
+    // Values stay valid for the lifetime of the dictionary
+    std::string_view Value(uint32_t id) const;
+    size_t Size() const;
+
+private:
+    uint32_t InternLocked(std::string_view value);
+
+    mutable std::mutex m_mutex;
+    std::pmr::monotonic_buffer_resource m_memory; // value bytes and table nodes; never moves them
+    std::pmr::vector<std::string_view> m_byId{&m_memory};
+    std::pmr::unordered_map<std::string_view, uint32_t> m_ids{&m_memory};
+};
+
+// One dictionary per key domain, shared by every file of an import
+struct KeyDictionaries
+{
+    KeyDictionary recipes;
+    KeyDictionary materials;
+
+    KeyDictionary *For(KeyDomain domain)
+    {
+        switch (domain)
+        {
+        case KeyDomain::Recipe:
+            return &recipes;
+        case KeyDomain::Material:
+            return &materials;
+        default:
+            return nullptr;
+        }
+    }
+};
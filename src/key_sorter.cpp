@@ -0,0 +1,373 @@
+#include "key_sorter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    // Rows decoded from runs before the scratch batch is reset
+    constexpr size_t kScratchRows = 4096;
+
+    // Bytes per held row besides its batch: the entry and its row reference
+    constexpr size_t kBytesPerRow = 24;
+
+    // Cell tags of a spilled row
+    enum CellTag : unsigned char
+    {
+        kNullCell,
+        kTextCell,
+        kIntegerCell,
+        kRealCell
+    };
+
+    template <typename T>
+    void Append(std::string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T Read(const char *&p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(value));
+        p += sizeof(value);
+        return value;
+    }
+
+    // Maps an integer key to an unsigned one with the same order
+    uint64_t OrderedBits(long long value)
+    {
+        return static_cast<uint64_t>(value) ^ (uint64_t(1) << 63);
+    }
+
+    double Seconds(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    }
+}
+
+KeySorter::KeySorter(TableColumns columns, size_t keyColumn, int minorColumn, const KeyDictionary &dictionary,
+                     size_t memoryBudget, std::string spillPath)
+    : m_columns(columns), m_keyColumn(keyColumn), m_minorColumn(minorColumn), m_dictionary(dictionary),
+      m_memoryBudget(memoryBudget), m_spillPath(std::move(spillPath))
+{
+}
+
+KeySorter::~KeySorter()
+{
+    CloseRuns();
+}
+
+uint32_t KeySorter::KeyId(const RowBatch &batch, size_t row) const
+{
+    const BatchColumn &column = batch.columns[m_keyColumn];
+    return column.IsNull(row) ? kNoKey : column.keys[row];
+}
+
+void KeySorter::Add(const RowBatch &batch, size_t row)
+{
+    uint64_t minor = 0;
+    if (m_minorColumn >= 0)
+    {
+        // A decimal only happens in a malformed file; its floor keeps equal keys equal
+        const BatchColumn &column = batch.columns[m_minorColumn];
+        long long value;
+        if (column.IsNull(row))
+            value = m_columns.columns[m_minorColumn].value.integer;
+        else if (column.IsReal(row))
+            value = static_cast<long long>(std::clamp(std::floor(column.numbers[row].real), -9.2e18, 9.2e18));
+        else
+            value = column.numbers[row].integer;
+        minor = OrderedBits(value);
+    }
+
+    // The id stands in for the rank until the entries are sorted
+    m_entries.push_back({minor, KeyId(batch, row), static_cast<uint32_t>(m_refs.size())});
+    m_refs.push_back({static_cast<uint32_t>(m_batches.size()), static_cast<uint32_t>(row)});
+    m_rows++;
+}
+
+bool KeySorter::Take(RowBatchPtr batch, std::string &error)
+{
+    // A batch none of whose rows were added is not needed
+    if (m_refs.empty() || m_refs.back().batch != m_batches.size())
+        return true;
+
+    m_heldBytes += batch->MemoryBytes() + batch->rowCount * kBytesPerRow;
+    m_batches.push_back(std::move(batch));
+    return m_heldBytes <= m_memoryBudget || Spill(error);
+}
+
+std::vector<uint32_t> KeySorter::RankKeys() const
+{
+    // Index 'count' stands for an empty key cell, which binds the column default
+    size_t count = m_dictionary.Size();
+    const char *empty = m_columns.columns[m_keyColumn].value.text;
+    std::vector<std::string_view> values(count + 1);
+    for (size_t id = 0; id < count; id++)
+        values[id] = m_dictionary.Value(static_cast<uint32_t>(id));
+    values[count] = empty ? empty : "";
+
+    std::vector<uint32_t> order(count + 1);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return values[a] < values[b]; });
+
+    // Equal values share a rank so that their rows stay in file order
+    std::vector<uint32_t> ranks(count + 1);
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        if (i > 0 && values[order[i]] != values[order[i - 1]])
+            rank++;
+        ranks[order[i]] = rank;
+    }
+    return ranks;
+}
+
+void KeySorter::SortEntries(const std::vector<uint32_t> &ranks)
+{
+    const uint32_t emptyRank = ranks.back();
+    for (Entry &entry : m_entries)
+        entry.rank = entry.rank == kNoKey ? emptyRank : ranks[entry.rank];
+
+    // LSD radix sort over the 12 key bytes, minor key first. Each pass is a
+    // stable counting sort; a byte that is the same in every entry is skipped.
+    constexpr size_t kDigits = 12;
+    auto digit = [](const Entry &entry, size_t d) -> size_t {
+        return d < 8 ? (entry.minor >> (8 * d)) & 0xFF : (entry.rank >> (8 * (d - 8))) & 0xFF;
+    };
+
+    std::vector<size_t> counts(kDigits * 256, 0);
+    for (const Entry &entry : m_entries)
+    {
+        for (size_t d = 0; d < kDigits; d++)
+            counts[d * 256 + digit(entry, d)]++;
+    }
+
+    std::vector<Entry> sorted(m_entries.size());
+    for (size_t d = 0; d < kDigits; d++)
+    {
+        size_t *bucket = &counts[d * 256];
+        if (std::find(bucket, bucket + 256, m_entries.size()) != bucket + 256)
+            continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; b++)
+        {
+            size_t n = bucket[b];
+            bucket[b] = offset;
+            offset += n;
+        }
+        for (const Entry &entry : m_entries)
+            sorted[bucket[digit(entry, d)]++] = entry;
+        m_entries.swap(sorted);
+    }
+}
+
+bool KeySorter::Spill(std::string &error)
+{
+    auto started = std::chrono::steady_clock::now();
+    SortEntries(RankKeys());
+
+    Run run;
+    run.path = m_spillPath + "." + std::to_string(m_runs.size());
+    std::FILE *file = std::fopen(run.path.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot create " + run.path;
+        return false;
+    }
+    m_runs.push_back(run);
+
+    // Each row: byte count, key id, minor key, file row, then one tagged cell per column
+    std::string record;
+    for (const Entry &entry : m_entries)
+    {
+        const RowRef &ref = m_refs[entry.ref];
+        const RowBatch &batch = *m_batches[ref.batch];
+        size_t row = ref.row;
+
+        record.assign(sizeof(uint32_t), '\0');
+        Append(record, KeyId(batch, row));
+        Append(record, entry.minor);
+        Append(record, static_cast<uint64_t>(batch.firstRow + row));
+        for (size_t i = 0; i < m_columns.count; i++)
+        {
+            const BatchColumn &column = batch.columns[i];
+            if (column.IsNull(row))
+            {
+                record.push_back(kNullCell);
+            }
+            else if (column.type == SqlType::Text)
+            {
+                std::string_view text = batch.Text(i, row);
+                record.push_back(kTextCell);
+                Append(record, static_cast<uint32_t>(text.size()));
+                record.append(text);
+            }
+            else if (column.type == SqlType::Real || column.IsReal(row))
+            {
+                record.push_back(kRealCell);
+                Append(record, column.numbers[row].real);
+            }
+            else
+            {
+                record.push_back(kIntegerCell);
+                Append(record, static_cast<int64_t>(column.numbers[row].integer));
+            }
+        }
+        uint32_t size = static_cast<uint32_t>(record.size() - sizeof(uint32_t));
+        std::memcpy(&record[0], &size, sizeof(size));
+        std::fwrite(record.data(), 1, record.size(), file);
+    }
+
+    bool written = !std::ferror(file);
+    written = std::fclose(file) == 0 && written;
+    if (!written)
+    {
+        error = "cannot write " + run.path;
+        return false;
+    }
+
+    m_batches.clear();
+    m_refs.clear();
+    m_entries.clear();
+    m_heldBytes = 0;
+    m_sortSeconds += Seconds(started);
+    return true;
+}
+
+bool KeySorter::Finish(std::string &error)
+{
+    auto started = std::chrono::steady_clock::now();
+    m_finalRanks = RankKeys();
+    SortEntries(m_finalRanks);
+    m_nextEntry = 0;
+
+    for (Run &run : m_runs)
+    {
+        run.file = std::fopen(run.path.c_str(), "rb");
+        if (!run.file)
+        {
+            error = "cannot read " + run.path;
+            return false;
+        }
+        std::setvbuf(run.file, nullptr, _IOFBF, 1 << 20);
+        if (!ReadRecord(run, m_finalRanks) && Failed())
+        {
+            error = m_error;
+            return false;
+        }
+    }
+    if (!m_runs.empty())
+        m_scratch.Reset(m_columns, kScratchRows);
+
+    m_sortSeconds += Seconds(started);
+    return true;
+}
+
+bool KeySorter::ReadRecord(Run &run, const std::vector<uint32_t> &ranks)
+{
+    uint32_t size;
+    if (std::fread(&size, sizeof(size), 1, run.file) != 1)
+    {
+        if (std::ferror(run.file))
+            m_error = "cannot read " + run.path;
+        run.done = true;
+        return false;
+    }
+    run.record.resize(size);
+    if (std::fread(&run.record[0], 1, size, run.file) != size)
+    {
+        m_error = "cannot read " + run.path;
+        run.done = true;
+        return false;
+    }
+
+    const char *p = run.record.data();
+    uint32_t id = Read<uint32_t>(p);
+    run.rank = id == kNoKey ? ranks.back() : ranks[id];
+    run.minor = Read<uint64_t>(p);
+    return true;
+}
+
+void KeySorter::Decode(const std::string &record, size_t &fileRow)
+{
+    if (m_scratch.rowCount == kScratchRows)
+        m_scratch.Reset(m_columns, kScratchRows);
+    size_t row = m_scratch.AddRow();
+
+    const char *p = record.data() + sizeof(uint32_t) + sizeof(uint64_t);
+    fileRow = static_cast<size_t>(Read<uint64_t>(p));
+    for (size_t i = 0; i < m_columns.count; i++)
+    {
+        switch (static_cast<unsigned char>(*p++))
+        {
+        case kTextCell:
+        {
+            uint32_t length = Read<uint32_t>(p);
+            m_scratch.SetText(i, row, std::string_view(p, length));
+            p += length;
+            break;
+        }
+        case kIntegerCell:
+            m_scratch.SetInteger(i, row, Read<int64_t>(p));
+            break;
+        case kRealCell:
+            m_scratch.SetReal(i, row, Read<double>(p));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool KeySorter::Next(const RowBatch *&batch, size_t &row, size_t &fileRow)
+{
+    // The smallest key among the runs and the rows still in memory. Runs are
+    // in file order and come before the memory rows, so on a tie the earlier
+    // source wins and rows with the same key keep their file order.
+    Run *best = nullptr;
+    for (Run &run : m_runs)
+    {
+        if (!run.done && (!best || run.rank < best->rank || (run.rank == best->rank && run.minor < best->minor)))
+            best = &run;
+    }
+
+    if (m_nextEntry < m_entries.size())
+    {
+        const Entry &entry = m_entries[m_nextEntry];
+        if (!best || entry.rank < best->rank || (entry.rank == best->rank && entry.minor < best->minor))
+        {
+            const RowRef &ref = m_refs[entry.ref];
+            batch = m_batches[ref.batch].get();
+            row = ref.row;
+            fileRow = batch->firstRow + row;
+            m_nextEntry++;
+            return true;
+        }
+    }
+
+    if (!best)
+        return false;
+    Decode(best->record, fileRow);
+    batch = &m_scratch;
+    row = m_scratch.rowCount - 1;
+    ReadRecord(*best, m_finalRanks);
+    return !Failed();
+}
+
+void KeySorter::CloseRuns()
+{
+    for (Run &run : m_runs)
+    {
+        if (run.file)
+            std::fclose(run.file);
+        std::remove(run.path.c_str());
+    }
+    m_runs.clear();
+}
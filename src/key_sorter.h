@@ -0,0 +1,131 @@
+// Puts a table's rows into primary key order before they are inserted
+#pragma once
+
+#include "key_dictionary.h"
+#include "row_batch.h"
+#include "table_schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Collects the rows of one table and hands them back sorted by primary key,
+// so the B-tree is filled by appends instead of inserts all over the file.
+//
+// The leading key column is an interned key; its dictionary ids are ranked by
+// their bytes, which is how SQLite orders TEXT keys. An optional second key
+// column is an INTEGER (RecipeLine.RcpLine). Rank and integer form a 96-bit
+// key that an LSD radix sort orders without comparing strings. The sort is
+// stable, so rows with the same key keep their file order and the last one
+// still replaces the others.
+//
+// Rows stay in their parsed batches. Once the batches take more than
+// 'memoryBudget' bytes they are sorted and written to a run file next to the
+// database ("<spillPath>.0", ".1", ...) and released; Finish() then merges
+// the runs with what is still in memory.
+class KeySorter
+{
+public:
+    // 'minorColumn' < 0 when the key has one column
+    KeySorter(TableColumns columns, size_t keyColumn, int minorColumn, const KeyDictionary &dictionary,
+              size_t memoryBudget, std::string spillPath);
+    ~KeySorter();
+
+    KeySorter(const KeySorter &) = delete;
+    KeySorter &operator=(const KeySorter &) = delete;
+
+    // Row 'row' of the batch that is passed to Take() next
+    void Add(const RowBatch &batch, size_t row);
+    // Keeps the batch until its rows are written; may spill a run
+    bool Take(RowBatchPtr batch, std::string &error);
+
+    // Sorts what is left in memory and opens the runs for merging
+    bool Finish(std::string &error);
+    // Rows in key order; 'fileRow' is the row's index within the CSV file.
+    // The batch is only valid until the next call.
+    bool Next(const RowBatch *&batch, size_t &row, size_t &fileRow);
+    bool Failed() const { return !m_error.empty(); }
+    const std::string &Error() const { return m_error; }
+
+    size_t Rows() const { return m_rows; }
+    size_t Runs() const { return m_runs.size(); }
+    double SortSeconds() const { return m_sortSeconds; }
+
+private:
+    // Key and position of a row held in memory
+    struct Entry
+    {
+        uint64_t minor;
+        uint32_t rank;
+        uint32_t ref; // index into m_refs
+    };
+
+    struct RowRef
+    {
+        uint32_t batch;
+        uint32_t row;
+    };
+
+    // A spilled run being merged
+    struct Run
+    {
+        std::string path;
+        std::FILE *file = nullptr;
+        std::string record; // current row, undecoded
+        uint32_t rank = 0;
+        uint64_t minor = 0;
+        bool done = false;
+    };
+
+    uint32_t KeyId(const RowBatch &batch, size_t row) const;
+    std::vector<uint32_t> RankKeys() const;
+    void SortEntries(const std::vector<uint32_t> &ranks);
+    bool Spill(std::string &error);
+    bool ReadRecord(Run &run, const std::vector<uint32_t> &ranks);
+    void Decode(const std::string &record, size_t &fileRow);
+    void CloseRuns();
+
+    TableColumns m_columns;
+    size_t m_keyColumn;
+    int m_minorColumn;
+    const KeyDictionary &m_dictionary;
+    size_t m_memoryBudget;
+    std::string m_spillPath;
+
+    std::vector<RowBatchPtr> m_batches;
+    std::vector<RowRef> m_refs;
+    std::vector<Entry> m_entries;
+    size_t m_heldBytes = 0;
+
+    std::vector<Run> m_runs;
+    std::vector<uint32_t> m_finalRanks; // ranks over the whole dictionary, for merging
+    size_t m_nextEntry = 0;
+    RowBatch m_scratch; // decoded rows of spilled runs
+    std::string m_error;
+
+    size_t m_rows = 0;
+    double m_sortSeconds = 0.0;
+};
+
+// The sorter for a schema whose key leads with an interned column
+template <typename Schema>
+std::unique_ptr<KeySorter> MakeKeySorter(const KeyDictionaries &keys, size_t memoryBudget, std::string spillPath)
+{
+    constexpr size_t keyColumn = Schema::kPrimaryKey[0];
+    static_assert(Schema::kColumns[keyColumn].key != KeyDomain::None, "leading key column must be interned");
+    constexpr int minorColumn = Schema::kPrimaryKey.size() > 1 ? static_cast<int>(Schema::kPrimaryKey.back()) : -1;
+    static_assert(Schema::kPrimaryKey.size() == 1 ||
+                      (Schema::kPrimaryKey.size() == 2 &&
+                       Schema::kColumns[Schema::kPrimaryKey.back()].value.type == SqlType::Integer),
+                  "second key column must be an INTEGER");
+
+    const KeyDomain domain = Schema::kColumns[keyColumn].key;
+    const KeyDictionary &dictionary = domain == KeyDomain::Recipe ? keys.recipes : keys.materials;
+    return std::make_unique<KeySorter>(ColumnsOf<Schema>(), keyColumn, minorColumn, dictionary, memoryBudget,
+                                       std::move(spillPath));
+}
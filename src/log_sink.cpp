@@ -0,0 +1,137 @@
+#include "log_sink.h"
+
+#include <algorithm>
+
+LogSink::LogSink() : m_started(std::chrono::steady_clock::now())
+{
+}
+
+LogSink::~LogSink()
+{
+    Node *node = m_head.exchange(nullptr);
+    while (node)
+    {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void LogSink::Write(std::string text)
+{
+    Node *node = new Node{{std::chrono::steady_clock::now(), std::move(text)}, nullptr};
+    node->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+bool LogSink::Drain(std::vector<LogRecord> &records)
+{
+    // Taking the whole list avoids ABA: producers only ever push onto an empty or live head
+    Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+    if (!node)
+        return false;
+
+    // The list is newest first
+    size_t first = records.size();
+    while (node)
+    {
+        Node *next = node->next;
+        records.push_back(std::move(node->record));
+        delete node;
+        node = next;
+    }
+    std::reverse(records.begin() + first, records.end());
+    return true;
+}
+
+std::string LogSink::Format(const LogRecord &record) const
+{
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time - m_started).count();
+    char stamp[32];
+    std::snprintf(stamp, sizeof(stamp), "[%lld.%03llds] ", static_cast<long long>(ms / 1000),
+                  static_cast<long long>(ms % 1000));
+    return stamp + record.text;
+}
+
+LogFileWriter::~LogFileWriter()
+{
+    Close();
+}
+
+bool LogFileWriter::Open(const std::string &filename)
+{
+    Close();
+    m_file = std::fopen(filename.c_str(), "ab");
+    if (!m_file)
+        return false;
+    m_closing = false;
+    m_thread = std::thread(&LogFileWriter::WriterThread, this);
+    return true;
+}
+
+void LogFileWriter::Write(std::vector<std::string> lines)
+{
+    if (!m_file || lines.empty())
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending.empty())
+        m_pending = std::move(lines);
+    else
+        m_pending.insert(m_pending.end(), std::make_move_iterator(lines.begin()), std::make_move_iterator(lines.end()));
+    m_wake.notify_one();
+}
+
+void LogFileWriter::Close()
+{
+    if (!m_file)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+        m_wake.notify_one();
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void LogFileWriter::WriterThread()
+{
+    std::vector<std::string> lines;
+    for (;;)
+    {
+        bool closing;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_closing || !m_pending.empty(); });
+            lines.swap(m_pending);
+            closing = m_closing;
+        }
+
+        for (const std::string &line : lines)
+        {
+            std::fwrite(line.data(), 1, line.size(), m_file);
+            std::fputc('\n', m_file);
+        }
+        if (!lines.empty())
+            std::fflush(m_file);
+        lines.clear();
+
+        if (closing)
+            return;
+    }
+}
+
+LogSink &AppLog()
+{
+    static LogSink log;
+    return log;
+}
+
+void AddLogMessage(const std::string &message)
+{
+    AppLog().Write(message);
+}
@@ -0,0 +1,84 @@
+// Non-blocking application log: any thread appends, one consumer drains in batches
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LogRecord
+{
+    std::chrono::steady_clock::time_point time;
+    std::string text;
+};
+
+// Multi-producer, single-consumer. Write() is one allocation plus a CAS loop
+// on the list head, so a worker never waits on the UI or on disk. Drain()
+// takes the whole pending list at once and returns it oldest first.
+class LogSink
+{
+public:
+    LogSink();
+    ~LogSink();
+
+    LogSink(const LogSink &) = delete;
+    LogSink &operator=(const LogSink &) = delete;
+
+    void Write(std::string text);
+
+    // Appends everything written so far to 'records'; returns false if there was nothing
+    bool Drain(std::vector<LogRecord> &records);
+
+    // "[12.345s] text", relative to when the sink was created
+    std::string Format(const LogRecord &record) const;
+
+private:
+    struct Node
+    {
+        LogRecord record;
+        Node *next;
+    };
+
+    std::atomic<Node *> m_head{nullptr};
+    std::chrono::steady_clock::time_point m_started;
+};
+
+// Keeps the full history on disk. Lines are handed over under a short lock
+// by the consumer of a LogSink and written by a background thread.
+class LogFileWriter
+{
+public:
+    LogFileWriter() = default;
+    ~LogFileWriter();
+
+    LogFileWriter(const LogFileWriter &) = delete;
+    LogFileWriter &operator=(const LogFileWriter &) = delete;
+
+    bool Open(const std::string &filename);
+    void Write(std::vector<std::string> lines);
+
+    // Writes what is still queued, then stops the thread and closes the file
+    void Close();
+
+    bool IsOpen() const { return m_file != nullptr; }
+
+private:
+    void WriterThread();
+
+    std::FILE *m_file = nullptr;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::string> m_pending;
+    bool m_closing = false;
+};
+
+// Process-wide log that the import code writes to
+LogSink &AppLog();
+
+// Queues a message on AppLog(); safe from any thread and never blocks
+void AddLogMessage(const std::string &message);
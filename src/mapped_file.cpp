@@ -0,0 +1,164 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_open = std::exchange(other.m_open, false);
+        m_error = std::move(other.m_error);
+#ifdef _WIN32
+        m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+        m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &filename)
+{
+    Close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        m_error = "CreateFile failed (" + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        m_error = "GetFileSizeEx failed (" + std::to_string(GetLastError()) + ")";
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_open = true;
+
+    // Empty files cannot be mapped, but they are still valid input
+    if (m_size == 0)
+        return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        m_error = "CreateFileMapping failed (" + std::to_string(GetLastError()) + ")";
+        Close();
+        return false;
+    }
+    m_mappingHandle = mapping;
+
+    m_data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        m_error = "MapViewOfFile failed (" + std::to_string(GetLastError()) + ")";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mappingHandle)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle)
+        CloseHandle(m_fileHandle);
+
+    m_data = nullptr;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &filename)
+{
+    Close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        m_error = std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        m_error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+    m_open = true;
+
+    // Empty files cannot be mapped, but they are still valid input
+    if (m_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+
+    void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        m_error = std::strerror(errno);
+        m_size = 0;
+        m_open = false;
+        return false;
+    }
+
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const char *>(data);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+        munmap(const_cast<char *>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
@@ -0,0 +1,38 @@
+// Read-only memory mapping of a whole file (mmap on POSIX, file mapping on Win32)
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // Maps the file; on failure returns false and Error() describes why
+    bool Open(const std::string &filename);
+    void Close();
+
+    bool IsOpen() const { return m_open; }
+    const char *Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    std::string_view View() const { return std::string_view(m_data, m_size); }
+    const std::string &Error() const { return m_error; }
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+    std::string m_error;
+#ifdef _WIN32
+    void *m_fileHandle = nullptr;
+    void *m_mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,66 @@
+#include "number_parse.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <system_error>
+
+namespace
+{
+    // from_chars rejects a leading '+', which the old SQL literals allowed
+    std::string_view SkipPlus(std::string_view text)
+    {
+        if (text.size() > 1 && text[0] == '+' && text[1] != '-')
+            text.remove_prefix(1);
+        return text;
+    }
+
+    bool ParseDot(const char *first, const char *last, double &value)
+    {
+#ifdef __cpp_lib_to_chars
+        std::from_chars_result result = std::from_chars(first, last, value);
+        return result.ec == std::errc() && result.ptr == last;
+#else
+        // Older standard libraries only have integer from_chars
+        char buffer[64];
+        size_t size = static_cast<size_t>(last - first);
+        if (size >= sizeof(buffer))
+            return false;
+        std::copy(first, last, buffer);
+        buffer[size] = '\0';
+        char *end = nullptr;
+        value = std::strtod(buffer, &end);
+        return end == buffer + size;
+#endif
+    }
+}
+
+bool ParseDecimal(std::string_view text, double &value)
+{
+    text = SkipPlus(text);
+    if (text.empty())
+        return false;
+
+    size_t comma = text.find(',');
+    if (comma == std::string_view::npos)
+        return ParseDot(text.data(), text.data() + text.size(), value);
+
+    // Numbers are short; rewrite the separator in a stack copy
+    char buffer[64];
+    if (text.size() > sizeof(buffer))
+        return false;
+    text.copy(buffer, text.size());
+    for (size_t i = comma; i < text.size(); i++)
+    {
+        if (buffer[i] == ',')
+            buffer[i] = '.';
+    }
+    return ParseDot(buffer, buffer + text.size(), value);
+}
+
+bool ParseInteger(std::string_view text, long long &value)
+{
+    text = SkipPlus(text);
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size() && !text.empty();
+}
@@ -0,0 +1,10 @@
+// Numeric cell parsing for REAL and INTEGER columns
+#pragma once
+
+#include <string_view>
+
+// Parses a decimal number; ',' is accepted as the decimal separator
+bool ParseDecimal(std::string_view text, double &value);
+
+// Parses a base-10 integer
+bool ParseInteger(std::string_view text, long long &value);
@@ -0,0 +1,119 @@
+#include "referential_check.h"
+#include "log_sink.h"
+
+const char *ForeignKeyModeName(ForeignKeyMode mode)
+{
+    switch (mode)
+    {
+    case ForeignKeyMode::Off:
+        return "off";
+    case ForeignKeyMode::Reject:
+        return "reject";
+    default:
+        return "report";
+    }
+}
+
+bool ParseForeignKeyMode(std::string_view name, ForeignKeyMode &mode)
+{
+    if (name == "off")
+        mode = ForeignKeyMode::Off;
+    else if (name == "report")
+        mode = ForeignKeyMode::Report;
+    else if (name == "reject")
+        mode = ForeignKeyMode::Reject;
+    else
+        return false;
+    return true;
+}
+
+void KeySet::Insert(uint32_t id)
+{
+    if (id == kNoKey)
+    {
+        m_hasEmpty = true;
+        return;
+    }
+    size_t word = id >> 6;
+    if (word >= m_bits.size())
+        m_bits.resize(word + 1 + m_bits.size() / 2);
+    m_bits[word] |= uint64_t(1) << (id & 63);
+}
+
+bool KeySet::Contains(uint32_t id) const
+{
+    if (id == kNoKey)
+        return m_hasEmpty;
+    size_t word = id >> 6;
+    return word < m_bits.size() && ((m_bits[word] >> (id & 63)) & 1);
+}
+
+bool LoadExistingKeys(sqlite3 *db, const char *table, const char *column, KeyDictionary &dictionary,
+                      KeySet &keys, std::string &error)
+{
+    std::string sql = std::string("SELECT ") + column + " FROM " + table;
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        const char *text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        int length = sqlite3_column_bytes(stmt, 0);
+        // Empty cells are stored as '' and parsed as kNoKey
+        keys.Insert(length > 0 ? dictionary.Intern(std::string_view(text, length)) : kNoKey);
+    }
+
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+OrphanReport::~OrphanReport()
+{
+    Close();
+}
+
+bool OrphanReport::Open(const std::string &filename, std::string &error)
+{
+    Close();
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (!m_file)
+    {
+        error = "cannot create " + filename;
+        return false;
+    }
+    std::fputs("Table;Row;Column;MissingKey\n", m_file);
+    return true;
+}
+
+void OrphanReport::Add(const char *table, size_t row, const char *column, std::string_view key)
+{
+    if (m_count < kLoggedOrphans)
+    {
+        AddLogMessage("WARNING: " + std::string(table) + " row " + std::to_string(row) + ": " + column + " '" +
+                      std::string(key) + "' has no parent row");
+    }
+    else if (m_count == kLoggedOrphans)
+    {
+        AddLogMessage("WARNING: further orphan rows are not logged individually");
+    }
+    m_count++;
+
+    if (m_file)
+        std::fprintf(m_file, "%s;%zu;%s;%.*s\n", table, row, column, static_cast<int>(key.size()), key.data());
+}
+
+void OrphanReport::Close()
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
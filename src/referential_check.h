@@ -0,0 +1,83 @@
+// Foreign key validation on dictionary ids, done before rows reach SQLite
+#pragma once
+
+#include "key_dictionary.h"
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class ForeignKeyMode
+{
+    Off,    // no check; orphan lines are inserted silently
+    Report, // insert everything, report the orphans
+    Reject  // report the orphans and do not insert them
+};
+
+const char *ForeignKeyModeName(ForeignKeyMode mode);
+bool ParseForeignKeyMode(std::string_view name, ForeignKeyMode &mode);
+
+// Dictionary ids present in a parent table, one bit each
+class KeySet
+{
+public:
+    void Insert(uint32_t id);
+    bool Contains(uint32_t id) const;
+
+private:
+    std::vector<uint64_t> m_bits;
+    bool m_hasEmpty = false; // kNoKey: the empty key
+};
+
+struct KeySets
+{
+    KeySet recipes;
+    KeySet materials;
+
+    KeySet *For(KeyDomain domain)
+    {
+        switch (domain)
+        {
+        case KeyDomain::Recipe:
+            return &recipes;
+        case KeyDomain::Material:
+            return &materials;
+        default:
+            return nullptr;
+        }
+    }
+};
+
+// Adds every value already stored in table.column to the dictionary and the set.
+// Used when a parent table had rows before this import or its file was skipped.
+bool LoadExistingKeys(sqlite3 *db, const char *table, const char *column, KeyDictionary &dictionary,
+                      KeySet &keys, std::string &error);
+
+// Collects orphan rows. The first few are logged; all of them go to an
+// optional ';' separated file with the row number, column and missing key.
+class OrphanReport
+{
+public:
+    OrphanReport() = default;
+    ~OrphanReport();
+
+    OrphanReport(const OrphanReport &) = delete;
+    OrphanReport &operator=(const OrphanReport &) = delete;
+
+    bool Open(const std::string &filename, std::string &error);
+    void Add(const char *table, size_t row, const char *column, std::string_view key);
+    void Close();
+
+    size_t Count() const { return m_count; }
+
+private:
+    static constexpr size_t kLoggedOrphans = 20;
+
+    std::FILE *m_file = nullptr;
+    size_t m_count = 0;
+};
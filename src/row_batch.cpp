@@ -0,0 +1,198 @@
+#include "row_batch.h"
+#include "transcode.h"
+
+#include <stdexcept>
+
+namespace
+{
+    // TextRef offsets are 32-bit
+    constexpr size_t kMaxArenaBytes = UINT32_MAX;
+
+    void ClearBit(std::pmr::vector<uint64_t> &bits, size_t row)
+    {
+        bits[row >> 6] &= ~(uint64_t(1) << (row & 63));
+    }
+
+    void SetBit(std::pmr::vector<uint64_t> &bits, size_t row)
+    {
+        bits[row >> 6] |= uint64_t(1) << (row & 63);
+    }
+
+    uint32_t ArenaOffset(const std::pmr::string &arena, size_t extra)
+    {
+        if (arena.size() + extra > kMaxArenaBytes)
+            throw std::length_error("row batch text exceeds 4 GiB");
+        return static_cast<uint32_t>(arena.size());
+    }
+}
+
+void *RowBatch::Overflow::do_allocate(size_t size, size_t alignment)
+{
+    bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+}
+
+void RowBatch::Overflow::do_deallocate(void *p, size_t size, size_t alignment)
+{
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+}
+
+bool RowBatch::Overflow::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+RowBatch::RowBatch()
+    : m_memory(std::in_place, &m_overflow), columns(&*m_memory), arena(&*m_memory), rowEnds(&*m_memory)
+{
+}
+
+void RowBatch::Reset(TableColumns schema, size_t rowCapacity)
+{
+    // Hand every buffer back before the arena is released
+    m_lastArenaSize = arena.size() > m_lastArenaSize ? arena.size() : m_lastArenaSize;
+    std::pmr::vector<BatchColumn>(&*m_memory).swap(columns);
+    std::pmr::string(&*m_memory).swap(arena);
+    std::pmr::vector<size_t>(&*m_memory).swap(rowEnds);
+
+    // Grow the arena's own buffer to everything the last fill used
+    size_t used = m_bufferSize + m_overflow.bytes;
+    if (used > m_bufferSize)
+    {
+        m_memory.reset();
+        m_buffer = std::make_unique<char[]>(used);
+        m_bufferSize = used;
+    }
+    if (m_bufferSize > 0)
+        m_memory.emplace(m_buffer.get(), m_bufferSize, &m_overflow);
+    else
+        m_memory.emplace(&m_overflow);
+    m_overflow.bytes = 0;
+
+    columns.reserve(schema.count);
+    for (size_t i = 0; i < schema.count; i++)
+    {
+        BatchColumn &column = columns.emplace_back(&*m_memory);
+        column.type = schema.columns[i].value.type;
+        column.key = schema.columns[i].key;
+        if (column.key != KeyDomain::None)
+            column.keys.reserve(rowCapacity);
+        if (column.type == SqlType::Text)
+            column.text.reserve(rowCapacity);
+        else
+            column.numbers.reserve(rowCapacity);
+        column.nulls.reserve((rowCapacity + 63) / 64);
+        if (column.type == SqlType::Integer)
+            column.reals.reserve((rowCapacity + 63) / 64);
+    }
+    arena.reserve(m_lastArenaSize);
+    rowEnds.reserve(rowCapacity);
+
+    rowCount = 0;
+    errors.clear();
+    firstRow = 0;
+    startOffset = 0;
+    endOffset = 0;
+}
+
+size_t RowBatch::AddRow()
+{
+    size_t row = rowCount++;
+    bool newWord = (row & 63) == 0;
+    for (BatchColumn &column : columns)
+    {
+        if (column.key != KeyDomain::None)
+            column.keys.push_back(kNoKey);
+        if (column.type == SqlType::Text)
+            column.text.push_back({0, 0});
+        else
+            column.numbers.push_back(NumberCell{0.0});
+
+        if (newWord)
+        {
+            column.nulls.push_back(~uint64_t(0));
+            if (column.type == SqlType::Integer)
+                column.reals.push_back(0);
+        }
+    }
+    return row;
+}
+
+void RowBatch::SetText(size_t column, size_t row, std::string_view text)
+{
+    uint32_t offset = ArenaOffset(arena, text.size());
+    arena.append(text.data(), text.size());
+    columns[column].text[row] = {offset, static_cast<uint32_t>(text.size())};
+    ClearBit(columns[column].nulls, row);
+}
+
+void RowBatch::SetLatin1Text(size_t column, size_t row, std::string_view latin1)
+{
+    // Transcode straight into the arena, then give back the unused tail
+    uint32_t offset = ArenaOffset(arena, Latin1ToUtf8MaxSize(latin1.size()));
+    arena.resize(offset + Latin1ToUtf8MaxSize(latin1.size()));
+    size_t written = TranscodeLatin1ToUtf8(latin1.data(), latin1.size(), &arena[offset]);
+    arena.resize(offset + written);
+    columns[column].text[row] = {offset, static_cast<uint32_t>(written)};
+    ClearBit(columns[column].nulls, row);
+}
+
+void RowBatch::SetReal(size_t column, size_t row, double value)
+{
+    BatchColumn &target = columns[column];
+    target.numbers[row].real = value;
+    if (target.type == SqlType::Integer)
+        SetBit(target.reals, row);
+    ClearBit(target.nulls, row);
+}
+
+void RowBatch::SetInteger(size_t column, size_t row, long long value)
+{
+    BatchColumn &target = columns[column];
+    target.numbers[row].integer = value;
+    ClearBit(target.nulls, row);
+}
+
+void RowBatch::SetKey(size_t column, size_t row, std::string_view raw, bool latin1)
+{
+    BatchColumn &target = columns[column];
+    auto [entry, inserted] = target.lookup.try_emplace(raw, static_cast<uint32_t>(target.distinct.size()));
+    if (inserted)
+    {
+        if (latin1)
+            SetLatin1Text(column, row, raw);
+        else
+            SetText(column, row, raw);
+        target.distinct.push_back(target.text[row]);
+    }
+    else
+    {
+        target.text[row] = target.distinct[entry->second];
+        ClearBit(target.nulls, row);
+    }
+    target.keys[row] = entry->second;
+}
+
+void RowBatch::MergeKeys(KeyDictionaries &dictionaries)
+{
+    for (BatchColumn &column : columns)
+    {
+        KeyDictionary *dictionary = dictionaries.For(column.key);
+        if (!dictionary || column.distinct.empty())
+            continue;
+
+        std::pmr::vector<std::string_view> values(&*m_memory);
+        values.reserve(column.distinct.size());
+        for (const TextRef &ref : column.distinct)
+            values.emplace_back(arena.data() + ref.offset, ref.length);
+
+        std::pmr::vector<uint32_t> ids(values.size(), &*m_memory);
+        dictionary->Intern(values.data(), values.size(), ids.data());
+
+        for (uint32_t &key : column.keys)
+        {
+            if (key != kNoKey)
+                key = ids[key];
+        }
+    }
+}
@@ -0,0 +1,140 @@
+// Column-major storage for a slice of parsed CSV rows
+#pragma once
+
+#include "key_dictionary.h"
+#include "table_schema.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A row that failed to parse; 'row' is its index within the batch. Cells
+// from 'column' on were not parsed.
+struct RowError
+{
+    size_t row;
+    size_t column;
+    std::string message;
+};
+
+// Location of a text cell inside RowBatch::arena
+struct TextRef
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+// A numeric cell. Real columns use 'real'; Integer columns use 'integer'
+// unless BatchColumn::IsReal says the cell only parsed as a decimal.
+union NumberCell
+{
+    double real;
+    long long integer;
+};
+
+// One column of a RowBatch; only the array for the column's type is filled.
+// Key columns are Text columns that also carry an id per row. Each distinct
+// value is stored once per batch and every row refers to that copy.
+struct BatchColumn
+{
+    explicit BatchColumn(std::pmr::memory_resource *memory)
+        : text(memory), numbers(memory), nulls(memory), reals(memory), keys(memory), distinct(memory),
+          lookup(memory)
+    {
+    }
+
+    SqlType type = SqlType::Text;
+    KeyDomain key = KeyDomain::None;
+    std::pmr::vector<TextRef> text;       // Text columns
+    std::pmr::vector<NumberCell> numbers; // Real and Integer columns
+    std::pmr::vector<uint64_t> nulls;     // bit per row: empty or missing cell, bind the default
+    std::pmr::vector<uint64_t> reals;     // Integer columns, bit per row: value held in 'real'
+
+    // Key columns: id per row (kNoKey when empty). Ids are batch-local until
+    // RowBatch::MergeKeys() maps them into the import's dictionary.
+    std::pmr::vector<uint32_t> keys;
+    std::pmr::vector<TextRef> distinct;                          // by batch-local id
+    std::pmr::unordered_map<std::string_view, uint32_t> lookup; // raw CSV bytes -> batch-local id
+
+    bool IsNull(size_t row) const { return (nulls[row >> 6] >> (row & 63)) & 1; }
+    bool IsReal(size_t row) const { return (reals[row >> 6] >> (row & 63)) & 1; }
+};
+
+// A fixed-size slice of parsed rows. Every cell of every column is one slot
+// in that column's array; all text of the batch shares a single UTF-8 arena.
+// A row starts out all null, so cells a line did not have need no storage
+// beyond their slot.
+//
+// Every buffer comes from a monotonic arena owned by the batch. Reset()
+// releases it in one go and sizes it to what the previous fill needed, so a
+// recycled batch is refilled without calling the global allocator. Batches
+// are passed around as RowBatchPtr and never copied or moved.
+struct RowBatch
+{
+private:
+    // Upstream of the arena: counts what did not fit the arena's own buffer
+    class Overflow : public std::pmr::memory_resource
+    {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void *do_allocate(size_t size, size_t alignment) override;
+        void do_deallocate(void *p, size_t size, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+    };
+
+    Overflow m_overflow;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_bufferSize = 0;
+    size_t m_lastArenaSize = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> m_memory;
+
+public:
+    RowBatch();
+    RowBatch(const RowBatch &) = delete;
+    RowBatch &operator=(const RowBatch &) = delete;
+
+    std::pmr::vector<BatchColumn> columns;
+    std::pmr::string arena;
+    std::pmr::vector<size_t> rowEnds; // by row: byte offset just past the row, filled by the CSV reader
+    size_t rowCount = 0;
+    std::vector<RowError> errors; // in row order
+    size_t firstRow = 0;          // index of row 0 within the file
+    size_t startOffset = 0;       // byte offset of row 0
+    size_t endOffset = 0;         // byte offset just past the last row
+
+    // Empties the batch and lays out one column per schema column
+    void Reset(TableColumns schema, size_t rowCapacity);
+
+    // Appends a row of null cells and returns its index
+    size_t AddRow();
+
+    void SetText(size_t column, size_t row, std::string_view text);
+    void SetLatin1Text(size_t column, size_t row, std::string_view latin1);
+    void SetReal(size_t column, size_t row, double value); // also for Integer columns
+    void SetInteger(size_t column, size_t row, long long value);
+
+    // Key cell from the raw CSV bytes, which must outlive the batch's parse
+    void SetKey(size_t column, size_t row, std::string_view raw, bool latin1);
+
+    // Interns the batch's distinct keys and rewrites the key ids to dictionary ids
+    void MergeKeys(KeyDictionaries &dictionaries);
+
+    std::string_view Text(size_t column, size_t row) const
+    {
+        const TextRef &ref = columns[column].text[row];
+        return std::string_view(arena.data() + ref.offset, ref.length);
+    }
+
+    // Bytes taken from the heap for the batch's buffers
+    size_t MemoryBytes() const { return m_bufferSize + m_overflow.bytes; }
+};
+
+using RowBatchPtr = std::unique_ptr<RowBatch>;
@@ -0,0 +1,268 @@
+#include "row_delta.h"
+
+namespace
+{
+    // bakery_key_hash(a, b, ...): RowKeyHash() computed from stored values
+    void KeyHashFunction(sqlite3_context *context, int argc, sqlite3_value **argv)
+    {
+        RowHasher hasher;
+        for (int i = 0; i < argc; i++)
+        {
+            switch (sqlite3_value_type(argv[i]))
+            {
+            case SQLITE_INTEGER:
+                hasher.AddInteger(sqlite3_value_int64(argv[i]));
+                break;
+            case SQLITE_FLOAT:
+                hasher.AddReal(sqlite3_value_double(argv[i]));
+                break;
+            case SQLITE_NULL:
+                hasher.AddNull();
+                break;
+            default:
+            {
+                const char *text = reinterpret_cast<const char *>(sqlite3_value_text(argv[i]));
+                hasher.AddText(std::string_view(text ? text : "", sqlite3_value_bytes(argv[i])));
+                break;
+            }
+            }
+        }
+        sqlite3_result_int64(context, static_cast<sqlite3_int64>(hasher.Value()));
+    }
+
+    bool Exec(sqlite3 *db, const std::string &sql, std::string &error)
+    {
+        char *errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) == SQLITE_OK)
+            return true;
+        error = errMsg ? errMsg : "Unknown";
+        sqlite3_free(errMsg);
+        return false;
+    }
+}
+
+const char *ImportModeName(ImportMode mode)
+{
+    return mode == ImportMode::Delta ? "delta" : "full";
+}
+
+bool ParseImportMode(std::string_view name, ImportMode &mode)
+{
+    if (name == "full")
+        mode = ImportMode::Full;
+    else if (name == "delta")
+        mode = ImportMode::Delta;
+    else
+        return false;
+    return true;
+}
+
+bool PrepareRowHashes(sqlite3 *db, std::string &error)
+{
+    if (sqlite3_create_function(db, "bakery_key_hash", -1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                                KeyHashFunction, nullptr, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    return Exec(db,
+                "CREATE TABLE IF NOT EXISTS ImportRowHash (\n"
+                "    TableName TEXT NOT NULL,\n"
+                "    KeyHash INTEGER NOT NULL,\n"
+                "    RowHash INTEGER NOT NULL,\n"
+                "    PRIMARY KEY (TableName, KeyHash)\n"
+                ") WITHOUT ROWID;\n",
+                error);
+}
+
+bool ClearRowHashes(sqlite3 *db, const char *table, std::string &error)
+{
+    sqlite3_stmt *stmt = nullptr;
+    bool exists = false;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'ImportRowHash'", -1,
+                           &stmt, nullptr) == SQLITE_OK)
+        exists = sqlite3_step(stmt) == SQLITE_ROW;
+    sqlite3_finalize(stmt);
+    if (!exists)
+        return true;
+
+    stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "DELETE FROM ImportRowHash WHERE TableName = ?", -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+RowHashStore::~RowHashStore()
+{
+    sqlite3_finalize(m_record);
+}
+
+bool RowHashStore::Load(sqlite3 *db, const char *table, const std::string &keyColumns, const std::string &columns,
+                        std::string &error)
+{
+    m_db = db;
+    m_table = table;
+    m_slots.assign(1024, Slot{0, 0, 0});
+    m_used = 0;
+    m_seeded = 0;
+
+    // No stored hashes: hash the rows the table holds now
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM ImportRowHash WHERE TableName = ? LIMIT 1", -1, &stmt, nullptr) !=
+        SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    if (rc == SQLITE_DONE)
+    {
+        if (!Exec(db,
+                  "INSERT OR REPLACE INTO ImportRowHash SELECT '" + m_table + "', bakery_key_hash(" + keyColumns +
+                      "), bakery_key_hash(" + columns + ") FROM " + m_table,
+                  error))
+            return false;
+        m_seeded = static_cast<size_t>(sqlite3_changes(db));
+    }
+
+    sqlite3_finalize(m_record);
+    m_record = nullptr;
+    if (sqlite3_prepare_v3(db, "INSERT OR REPLACE INTO ImportRowHash VALUES (?, ?, ?)", -1,
+                           SQLITE_PREPARE_PERSISTENT, &m_record, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(m_record, 1, m_table.c_str(), -1, SQLITE_STATIC);
+
+    stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT KeyHash, RowHash FROM ImportRowHash WHERE TableName = ?", -1, &stmt,
+                           nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        if (m_used * 10 >= m_slots.size() * 7)
+            Grow();
+        Slot &slot = Find(static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)));
+        if (slot.state == 0)
+            m_used++;
+        slot = {static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)),
+                static_cast<uint64_t>(sqlite3_column_int64(stmt, 1)), 1};
+    }
+
+    if (rc != SQLITE_DONE)
+        error = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+RowHashStore::Slot &RowHashStore::Find(uint64_t keyHash)
+{
+    // Keys are hashes already, so their low bits index the table directly
+    size_t mask = m_slots.size() - 1;
+    size_t index = keyHash & mask;
+    while (m_slots[index].state != 0 && m_slots[index].key != keyHash)
+        index = (index + 1) & mask;
+    return m_slots[index];
+}
+
+void RowHashStore::Grow()
+{
+    std::vector<Slot> old(m_slots.size() * 2, Slot{0, 0, 0});
+    old.swap(m_slots);
+    for (const Slot &slot : old)
+    {
+        if (slot.state != 0)
+            Find(slot.key) = slot;
+    }
+}
+
+RowChange RowHashStore::Classify(uint64_t keyHash, uint64_t rowHash)
+{
+    Slot &slot = Find(keyHash);
+    if (slot.state == 0)
+        return RowChange::Inserted;
+    slot.state = 2;
+    return slot.hash == rowHash ? RowChange::Unchanged : RowChange::Changed;
+}
+
+bool RowHashStore::Record(uint64_t keyHash, uint64_t rowHash)
+{
+    if (m_used * 10 >= m_slots.size() * 7)
+        Grow();
+    Slot &slot = Find(keyHash);
+    if (slot.state == 0)
+        m_used++;
+    // Seen, so a later duplicate of the key compares against this row
+    slot = {keyHash, rowHash, 2};
+
+    sqlite3_bind_int64(m_record, 2, static_cast<sqlite3_int64>(keyHash));
+    sqlite3_bind_int64(m_record, 3, static_cast<sqlite3_int64>(rowHash));
+    int rc = sqlite3_step(m_record);
+    sqlite3_reset(m_record);
+    return rc == SQLITE_DONE;
+}
+
+bool RowHashStore::DeleteUnseen(const std::string &keyColumns, size_t &deleted, std::string &error)
+{
+    deleted = 0;
+    if (!Exec(m_db,
+              "CREATE TEMP TABLE IF NOT EXISTS ImportGoneKeys (KeyHash INTEGER PRIMARY KEY);\n"
+              "DELETE FROM temp.ImportGoneKeys;\n",
+              error))
+        return false;
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO temp.ImportGoneKeys VALUES (?)", -1, &stmt, nullptr) !=
+        SQLITE_OK)
+    {
+        error = sqlite3_errmsg(m_db);
+        return false;
+    }
+    size_t gone = 0;
+    for (const Slot &slot : m_slots)
+    {
+        if (slot.state != 1)
+            continue;
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(slot.key));
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        gone++;
+    }
+    sqlite3_finalize(stmt);
+    if (gone == 0)
+        return true;
+
+    // One scan of the table; only runs when rows have disappeared from the CSV
+    if (!Exec(m_db,
+              "DELETE FROM " + m_table + " WHERE bakery_key_hash(" + keyColumns +
+                  ") IN (SELECT KeyHash FROM temp.ImportGoneKeys)",
+              error))
+        return false;
+    deleted = static_cast<size_t>(sqlite3_changes(m_db));
+
+    return Exec(m_db,
+                "DELETE FROM ImportRowHash WHERE TableName = '" + m_table +
+                    "' AND KeyHash IN (SELECT KeyHash FROM temp.ImportGoneKeys)",
+                error);
+}
@@ -0,0 +1,211 @@
+// Delta imports: a content hash per primary key decides which rows to write
+#pragma once
+
+#include "row_batch.h"
+#include "table_schema.h"
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+enum class ImportMode
+{
+    Full, // write every row with INSERT OR REPLACE
+    Delta // write only rows whose content hash changed; delete rows that are gone
+};
+
+const char *ImportModeName(ImportMode mode);
+bool ParseImportMode(std::string_view name, ImportMode &mode);
+
+// 64-bit hash of a sequence of typed cell values. A Real that holds a whole
+// number hashes like the Integer, matching how SQLite stores it in an
+// INTEGER column, so a hash of parsed cells equals the hash of stored ones.
+class RowHasher
+{
+public:
+    void AddText(std::string_view text)
+    {
+        Add(kTextTag ^ (uint64_t(text.size()) << 8));
+        size_t i = 0;
+        for (; i + 8 <= text.size(); i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, text.data() + i, 8);
+            Add(word);
+        }
+        if (i < text.size())
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, text.data() + i, text.size() - i);
+            Add(word);
+        }
+    }
+
+    void AddInteger(long long value)
+    {
+        Add(kIntegerTag);
+        Add(static_cast<uint64_t>(value));
+    }
+
+    void AddReal(double value)
+    {
+        if (value >= -9.2e18 && value <= 9.2e18 && value == static_cast<double>(static_cast<long long>(value)))
+        {
+            AddInteger(static_cast<long long>(value));
+            return;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &value, 8);
+        Add(kRealTag);
+        Add(bits);
+    }
+
+    void AddNull() { Add(kNullTag); }
+
+    uint64_t Value() const
+    {
+        uint64_t h = m_state;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 33);
+    }
+
+private:
+    static constexpr uint64_t kNullTag = 1;
+    static constexpr uint64_t kIntegerTag = 2;
+    static constexpr uint64_t kRealTag = 3;
+    static constexpr uint64_t kTextTag = 4;
+
+    void Add(uint64_t word)
+    {
+        uint64_t h = m_state ^ (word * 0x9E3779B97F4A7C15ULL);
+        h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        m_state = h ^ (h >> 32);
+    }
+
+    uint64_t m_state = 0x243F6A8885A308D3ULL;
+};
+
+namespace detail
+{
+    // Hashes the value BindColumn would bind for this cell
+    template <typename Schema, size_t I>
+    void HashCell(RowHasher &hasher, const RowBatch &batch, size_t row)
+    {
+        constexpr TypedDefault def = Schema::kColumns[I].value;
+        const BatchColumn &column = batch.columns[I];
+
+        if constexpr (def.type == SqlType::Text)
+            hasher.AddText(column.IsNull(row) ? std::string_view(def.text) : batch.Text(I, row));
+        else if constexpr (def.type == SqlType::Real)
+            hasher.AddReal(column.IsNull(row) ? def.real : column.numbers[row].real);
+        else if (column.IsNull(row))
+            hasher.AddInteger(def.integer);
+        else if (column.IsReal(row))
+            hasher.AddReal(column.numbers[row].real);
+        else
+            hasher.AddInteger(column.numbers[row].integer);
+    }
+
+    template <typename Schema, size_t... I>
+    uint64_t HashColumns(const RowBatch &batch, size_t row, std::index_sequence<I...>)
+    {
+        RowHasher hasher;
+        (HashCell<Schema, I>(hasher, batch, row), ...);
+        return hasher.Value();
+    }
+
+    template <typename Schema, size_t... K>
+    uint64_t HashKey(const RowBatch &batch, size_t row, std::index_sequence<K...>)
+    {
+        RowHasher hasher;
+        (HashCell<Schema, Schema::kPrimaryKey[K]>(hasher, batch, row), ...);
+        return hasher.Value();
+    }
+}
+
+// Hash of every cell of a row, as it would be written
+template <typename Schema>
+uint64_t RowContentHash(const RowBatch &batch, size_t row)
+{
+    return detail::HashColumns<Schema>(batch, row, std::make_index_sequence<Schema::kColumns.size()>());
+}
+
+// Hash of a row's primary key cells; equals bakery_key_hash() over the stored key.
+// RowContentHash() likewise equals bakery_key_hash() over all stored columns.
+template <typename Schema>
+uint64_t RowKeyHash(const RowBatch &batch, size_t row)
+{
+    return detail::HashKey<Schema>(batch, row, std::make_index_sequence<Schema::kPrimaryKey.size()>());
+}
+
+// Adds the ImportRowHash table and the bakery_key_hash() SQL function
+bool PrepareRowHashes(sqlite3 *db, std::string &error);
+
+// Forgets the stored hashes of one table. A full import does this for each
+// table it rewrites, so that the next delta import does not compare against
+// rows the full import may have changed.
+bool ClearRowHashes(sqlite3 *db, const char *table, std::string &error);
+
+enum class RowChange
+{
+    Inserted,
+    Changed,
+    Unchanged
+};
+
+// The stored row hashes of one table, held in an open-addressing table for
+// the duration of its import
+class RowHashStore
+{
+public:
+    RowHashStore() = default;
+    ~RowHashStore();
+
+    RowHashStore(const RowHashStore &) = delete;
+    RowHashStore &operator=(const RowHashStore &) = delete;
+
+    // Reads the table's stored hashes. A table with rows but no stored hashes
+    // was written by a full import or before the first delta import; its rows
+    // are hashed from the table first, so that unchanged rows compare equal
+    // and rows missing from the CSV are deleted. 'keyColumns' is the primary
+    // key and 'columns' every column, each as "a, b".
+    bool Load(sqlite3 *db, const char *table, const std::string &keyColumns, const std::string &columns,
+              std::string &error);
+    size_t Seeded() const { return m_seeded; } // rows hashed from the table by Load()
+
+    // Compares a parsed row against the stored hash and marks its key as seen.
+    // For Inserted and Changed rows the new hash is stored with Record().
+    RowChange Classify(uint64_t keyHash, uint64_t rowHash);
+    bool Record(uint64_t keyHash, uint64_t rowHash);
+
+    // Deletes the rows whose key was not seen from the table and from the
+    // stored hashes. 'keyColumns' is the table's primary key as "a, b".
+    bool DeleteUnseen(const std::string &keyColumns, size_t &deleted, std::string &error);
+
+private:
+    struct Slot
+    {
+        uint64_t key;
+        uint64_t hash;
+        uint8_t state; // 0 empty, 1 stored, 2 seen
+    };
+
+    Slot &Find(uint64_t keyHash);
+    void Grow();
+
+    sqlite3 *m_db = nullptr;
+    std::string m_table;
+    sqlite3_stmt *m_record = nullptr;
+    std::vector<Slot> m_slots;
+    size_t m_used = 0;
+    size_t m_seeded = 0;
+};
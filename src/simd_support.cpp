@@ -0,0 +1,35 @@
+#include "simd_support.h"
+
+namespace
+{
+#ifdef BAKERY_HAS_SSE2
+    bool CpuHasAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+}
+
+SimdLevel DetectSimdLevel()
+{
+#ifdef BAKERY_HAS_SSE2
+    static const SimdLevel detected = CpuHasAvx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    return detected;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
@@ -0,0 +1,23 @@
+// SIMD capability helpers shared by the tokenizer and transcoder kernels
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BAKERY_HAS_SSE2 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BAKERY_TARGET_AVX2
+#else
+#define BAKERY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Highest level supported by this CPU and OS (detected once)
+SimdLevel DetectSimdLevel();
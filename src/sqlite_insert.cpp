@@ -0,0 +1,53 @@
+#include "sqlite_insert.h"
+
+PreparedInsert::~PreparedInsert()
+{
+    sqlite3_finalize(m_stmt);
+}
+
+bool PreparedInsert::Prepare(sqlite3 *db, const std::string &table, size_t columnCount)
+{
+    sqlite3_finalize(m_stmt);
+    m_stmt = nullptr;
+    m_db = db;
+
+    std::string sql = "INSERT OR REPLACE INTO " + table + " VALUES (";
+    for (size_t i = 0; i < columnCount; i++)
+        sql += (i == 0) ? "?" : ",?";
+    sql += ")";
+
+    return sqlite3_prepare_v3(db, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &m_stmt, nullptr) == SQLITE_OK;
+}
+
+bool PreparedInsert::BindText(size_t index, std::string_view text)
+{
+    return sqlite3_bind_text(m_stmt, static_cast<int>(index) + 1, text.data(), static_cast<int>(text.size()),
+                             SQLITE_STATIC) == SQLITE_OK;
+}
+
+bool PreparedInsert::BindReal(size_t index, double value)
+{
+    return sqlite3_bind_double(m_stmt, static_cast<int>(index) + 1, value) == SQLITE_OK;
+}
+
+bool PreparedInsert::BindInteger(size_t index, long long value)
+{
+    return sqlite3_bind_int64(m_stmt, static_cast<int>(index) + 1, value) == SQLITE_OK;
+}
+
+bool PreparedInsert::Execute()
+{
+    int rc = sqlite3_step(m_stmt);
+    sqlite3_reset(m_stmt);
+    return rc == SQLITE_DONE;
+}
+
+const char *PreparedInsert::ErrorMessage() const
+{
+    return m_db ? sqlite3_errmsg(m_db) : "statement not prepared";
+}
+
+int PreparedInsert::ErrorCode() const
+{
+    return m_db ? sqlite3_errcode(m_db) : SQLITE_MISUSE;
+}
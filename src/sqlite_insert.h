@@ -0,0 +1,38 @@
+// Reusable prepared INSERT statements with typed parameter binding
+#pragma once
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// One "INSERT OR REPLACE INTO <table> VALUES (?, ...)" statement, prepared once
+// and reset after every row
+class PreparedInsert
+{
+public:
+    PreparedInsert() = default;
+    ~PreparedInsert();
+
+    PreparedInsert(const PreparedInsert &) = delete;
+    PreparedInsert &operator=(const PreparedInsert &) = delete;
+
+    bool Prepare(sqlite3 *db, const std::string &table, size_t columnCount);
+
+    // Bind column 'index' (0-based). Text is bound SQLITE_STATIC, so it must
+    // stay alive until Execute().
+    bool BindText(size_t index, std::string_view text);
+    bool BindReal(size_t index, double value);
+    bool BindInteger(size_t index, long long value);
+
+    // Steps the statement and resets it for the next row
+    bool Execute();
+
+    const char *ErrorMessage() const;
+    int ErrorCode() const; // primary result code of the failure
+
+private:
+    sqlite3 *m_db = nullptr;
+    sqlite3_stmt *m_stmt = nullptr;
+};
@@ -0,0 +1,149 @@
+#include "sqlite_session.h"
+
+namespace
+{
+    struct ProfileSettings
+    {
+        const char *journalMode; // nullptr leaves the database's mode alone
+        int synchronous;         // 0 = OFF, 1 = NORMAL, 2 = FULL
+        long long cacheSize;     // negative = KiB
+        int tempStore;           // 2 = MEMORY
+        const char *lockingMode;
+        long long mmapSize;
+        long long walAutocheckpoint; // pages; 0 = the importer checkpoints, -1 leaves it alone
+    };
+
+    // MEMORY rather than OFF keeps ROLLBACK working when a row fails
+    const ProfileSettings kBulkLoad = {"MEMORY", 0, -262144, 2, "EXCLUSIVE", 1LL << 30, -1};
+    const ProfileSettings kSafe = {nullptr, 2, -65536, 2, "NORMAL", 256LL << 20, -1};
+    // ROLLBACK is unreliable without a journal; a failed staging import is thrown away instead
+    const ProfileSettings kStaging = {"OFF", 0, -262144, 2, "EXCLUSIVE", 1LL << 30, -1};
+    // NORMAL sync is durable up to the last checkpoint in WAL mode and keeps commits short
+    const ProfileSettings kOnline = {"WAL", 1, -65536, 2, "NORMAL", 256LL << 20, 0};
+
+    bool QueryText(sqlite3 *db, const char *sql, std::string &value)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+            return false;
+        bool ok = sqlite3_step(stmt) == SQLITE_ROW;
+        if (ok)
+        {
+            const unsigned char *text = sqlite3_column_text(stmt, 0);
+            value = text ? reinterpret_cast<const char *>(text) : "";
+        }
+        sqlite3_finalize(stmt);
+        return ok;
+    }
+
+    bool QueryInteger(sqlite3 *db, const char *sql, long long &value)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+            return false;
+        bool ok = sqlite3_step(stmt) == SQLITE_ROW;
+        if (ok)
+            value = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+        return ok;
+    }
+
+    // Pragmas that return rows (journal_mode, locking_mode) still work through exec
+    bool Pragma(sqlite3 *db, const std::string &pragma, std::string &error)
+    {
+        std::string sql = "PRAGMA " + pragma;
+        char *errMsg = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK)
+        {
+            error = sql + ": " + (errMsg ? errMsg : "Unknown");
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
+    }
+}
+
+const char *SessionProfileName(SessionProfile profile)
+{
+    switch (profile)
+    {
+    case SessionProfile::Safe:
+        return "safe";
+    case SessionProfile::Staging:
+        return "staging";
+    case SessionProfile::Online:
+        return "online";
+    default:
+        return "bulk-load";
+    }
+}
+
+bool ParseSessionProfile(std::string_view name, SessionProfile &profile)
+{
+    if (name == "bulk-load" || name == "bulk")
+        profile = SessionProfile::BulkLoad;
+    else if (name == "safe")
+        profile = SessionProfile::Safe;
+    else if (name == "staging")
+        profile = SessionProfile::Staging;
+    else if (name == "online")
+        profile = SessionProfile::Online;
+    else
+        return false;
+    return true;
+}
+
+bool SessionSettings::Apply(sqlite3 *db, SessionProfile profile, std::string &error)
+{
+    m_db = db;
+    m_profile = profile;
+
+    QueryText(db, "PRAGMA journal_mode", m_journalMode);
+    QueryInteger(db, "PRAGMA synchronous", m_synchronous);
+    QueryInteger(db, "PRAGMA cache_size", m_cacheSize);
+    QueryInteger(db, "PRAGMA temp_store", m_tempStore);
+    QueryText(db, "PRAGMA locking_mode", m_lockingMode);
+    QueryInteger(db, "PRAGMA mmap_size", m_mmapSize);
+    QueryInteger(db, "PRAGMA wal_autocheckpoint", m_walAutocheckpoint);
+
+    // Another writer or a checkpoint may hold the lock briefly; wait instead of failing
+    if (profile == SessionProfile::Online)
+        sqlite3_busy_timeout(db, 5000);
+
+    const ProfileSettings &settings = profile == SessionProfile::Safe      ? kSafe
+                                      : profile == SessionProfile::Staging ? kStaging
+                                      : profile == SessionProfile::Online  ? kOnline
+                                                                           : kBulkLoad;
+    if (settings.journalMode && !Pragma(db, std::string("journal_mode = ") + settings.journalMode, error))
+        return false;
+    return Pragma(db, "synchronous = " + std::to_string(settings.synchronous), error) &&
+           Pragma(db, "cache_size = " + std::to_string(settings.cacheSize), error) &&
+           Pragma(db, "temp_store = " + std::to_string(settings.tempStore), error) &&
+           Pragma(db, std::string("locking_mode = ") + settings.lockingMode, error) &&
+           Pragma(db, "mmap_size = " + std::to_string(settings.mmapSize), error) &&
+           (settings.walAutocheckpoint < 0 ||
+            Pragma(db, "wal_autocheckpoint = " + std::to_string(settings.walAutocheckpoint), error));
+}
+
+void SessionSettings::Restore()
+{
+    if (!m_db)
+        return;
+
+    std::string ignored;
+    // Leaving WAL needs the database to itself, which an online import must not assume
+    if (!m_journalMode.empty() && m_profile != SessionProfile::Online)
+        Pragma(m_db, "journal_mode = " + m_journalMode, ignored);
+    Pragma(m_db, "synchronous = " + std::to_string(m_synchronous), ignored);
+    Pragma(m_db, "cache_size = " + std::to_string(m_cacheSize), ignored);
+    Pragma(m_db, "temp_store = " + std::to_string(m_tempStore), ignored);
+    Pragma(m_db, "mmap_size = " + std::to_string(m_mmapSize), ignored);
+    Pragma(m_db, "wal_autocheckpoint = " + std::to_string(m_walAutocheckpoint), ignored);
+    if (!m_lockingMode.empty())
+    {
+        // An exclusive lock is only released by the next access in NORMAL mode
+        Pragma(m_db, "locking_mode = " + m_lockingMode, ignored);
+        sqlite3_exec(m_db, "SELECT 1 FROM sqlite_master LIMIT 1", nullptr, nullptr, nullptr);
+    }
+    m_db = nullptr;
+}
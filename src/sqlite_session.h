@@ -0,0 +1,40 @@
+// Connection-level PRAGMA profiles applied for the duration of an import
+#pragma once
+
+#include <sqlite3.h>
+
+#include <string>
+#include <string_view>
+
+enum class SessionProfile
+{
+    BulkLoad, // fastest: in-memory journal, no fsync, exclusive lock, big cache
+    Safe,     // for live production databases: durable commits, shared locking
+    Staging,  // private staging file: no journal, no fsync; a failed import discards the file
+    Online    // WAL with chunked commits and manual checkpoints; readers keep working
+};
+
+const char *SessionProfileName(SessionProfile profile);
+bool ParseSessionProfile(std::string_view name, SessionProfile &profile);
+
+// Applies a profile and remembers the previous settings. Call Restore()
+// before closing the connection; settings are not restored automatically.
+class SessionSettings
+{
+public:
+    bool Apply(sqlite3 *db, SessionProfile profile, std::string &error);
+    void Restore();
+
+    SessionProfile Profile() const { return m_profile; }
+
+private:
+    sqlite3 *m_db = nullptr;
+    SessionProfile m_profile = SessionProfile::BulkLoad;
+    std::string m_journalMode;
+    long long m_synchronous = 2;
+    long long m_cacheSize = -2000;
+    long long m_tempStore = 0;
+    std::string m_lockingMode;
+    long long m_mmapSize = 0;
+    long long m_walAutocheckpoint = 1000;
+};
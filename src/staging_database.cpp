@@ -0,0 +1,244 @@
+#include "staging_database.h"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const char *const kReadersSuffix = ".readers";
+
+    bool FileExists(const std::string &path)
+    {
+        std::error_code ec;
+        return fs::exists(path, ec);
+    }
+
+    void RemoveDatabaseFiles(const std::string &path)
+    {
+        std::error_code ec;
+        for (const char *suffix : {"", "-journal", "-wal", "-shm"})
+            fs::remove(path + suffix, ec);
+    }
+
+    // Copies all of 'fromPath' into 'toPath'; the destination changes in one transaction
+    bool CopyDatabase(const std::string &fromPath, const std::string &toPath, std::string &error)
+    {
+        sqlite3 *from = nullptr;
+        sqlite3 *to = nullptr;
+        int rc = sqlite3_open_v2(fromPath.c_str(), &from, SQLITE_OPEN_READONLY, nullptr);
+        if (rc == SQLITE_OK)
+            rc = sqlite3_open_v2(toPath.c_str(), &to, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
+        if (rc == SQLITE_OK)
+        {
+            sqlite3_busy_timeout(to, 10000);
+            sqlite3_backup *backup = sqlite3_backup_init(to, "main", from, "main");
+            if (!backup)
+            {
+                rc = sqlite3_errcode(to);
+            }
+            else
+            {
+                // A writer on the source makes a step return BUSY; retry for up to 10 s
+                for (int attempt = 0; attempt < 200; attempt++)
+                {
+                    rc = sqlite3_backup_step(backup, -1);
+                    if (rc != SQLITE_BUSY && rc != SQLITE_LOCKED)
+                        break;
+                    sqlite3_sleep(50);
+                }
+                int finish = sqlite3_backup_finish(backup);
+                rc = rc == SQLITE_DONE ? finish : rc;
+            }
+        }
+        if (rc != SQLITE_OK)
+            error = "copying " + fromPath + " to " + toPath + ": " + sqlite3_errstr(rc);
+        sqlite3_close(from);
+        sqlite3_close(to);
+        return rc == SQLITE_OK;
+    }
+
+    // With synchronous=OFF nothing was flushed while the staging file was written
+    bool FlushToDisk(const std::string &path)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        bool ok = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return ok;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        bool ok = fsync(fd) == 0;
+        close(fd);
+        return ok;
+#endif
+    }
+
+#ifndef _WIN32
+    // Locks "<target>.readers" exclusively if it exists and no reader holds it.
+    // Returns the descriptor to close after the rename, or -1.
+    int LockOutReaders(const std::string &target)
+    {
+        int fd = open((target + kReadersSuffix).c_str(), O_RDWR | O_CLOEXEC);
+        if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+#endif
+
+    // A hot journal or a WAL file belongs to the old database file; the new one
+    // must not be paired with it. A failed EXCLUSIVE lock means a connection is
+    // reading or writing right now. Idle connections are not seen: on Windows
+    // they make the rename itself fail, on POSIX LockOutReaders() covers them.
+    bool CanReplaceByRename(const std::string &target)
+    {
+        if (FileExists(target + "-journal") || FileExists(target + "-wal"))
+            return false;
+
+        sqlite3 *db = nullptr;
+        bool unlocked = sqlite3_open_v2(target.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK &&
+                        sqlite3_exec(db, "BEGIN EXCLUSIVE", nullptr, nullptr, nullptr) == SQLITE_OK;
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+        return unlocked && !FileExists(target + "-wal");
+    }
+
+    // Fails on Windows while any process has the target open
+    bool ReplaceFile(const std::string &from, const std::string &to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        if (std::rename(from.c_str(), to.c_str()) != 0)
+            return false;
+        // Make the rename itself durable
+        fs::path directory = fs::absolute(fs::path(to)).parent_path();
+        int fd = open(directory.string().c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            fsync(fd);
+            close(fd);
+        }
+        return true;
+#endif
+    }
+}
+
+StagingDatabase::~StagingDatabase()
+{
+    Discard();
+}
+
+bool StagingDatabase::Create(const std::string &targetPath, std::string &error)
+{
+    m_targetPath = targetPath;
+    m_path = targetPath + ".staging";
+    RemoveDatabaseFiles(m_path); // left over from an interrupted run
+
+    if (FileExists(targetPath) && !CopyDatabase(targetPath, m_path, error))
+    {
+        Discard();
+        return false;
+    }
+    return true;
+}
+
+bool StagingDatabase::Publish(std::string &method, std::string &error)
+{
+    if (!FlushToDisk(m_path))
+    {
+        error = "cannot flush " + m_path;
+        return false;
+    }
+
+    bool renamed = false;
+    if (!FileExists(m_targetPath))
+    {
+        renamed = ReplaceFile(m_path, m_targetPath);
+    }
+    else
+    {
+#ifdef _WIN32
+        renamed = CanReplaceByRename(m_targetPath) && ReplaceFile(m_path, m_targetPath);
+#else
+        // Held until the rename is done, so a reader that arrives meanwhile opens the new file
+        int readersLock = LockOutReaders(m_targetPath);
+        renamed = readersLock >= 0 && CanReplaceByRename(m_targetPath) && ReplaceFile(m_path, m_targetPath);
+        if (readersLock >= 0)
+            close(readersLock);
+#endif
+    }
+    if (renamed)
+    {
+        method = "renamed over the target";
+        m_path.clear();
+        return true;
+    }
+
+    // Readers may have the target open: copy into it under SQLite's own locking
+    if (!CopyDatabase(m_path, m_targetPath, error))
+        return false;
+    method = "copied into the target with the backup API";
+    Discard();
+    return true;
+}
+
+StagingReaderLock::~StagingReaderLock()
+{
+    Release();
+}
+
+bool StagingReaderLock::Acquire(const std::string &targetPath, std::string &error)
+{
+    Release();
+#ifdef _WIN32
+    (void)targetPath;
+    (void)error;
+#else
+    std::string path = targetPath + kReadersSuffix;
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (m_fd < 0 || flock(m_fd, LOCK_SH) != 0)
+    {
+        error = "cannot lock " + path;
+        Release();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void StagingReaderLock::Release()
+{
+#ifndef _WIN32
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+    m_fd = -1;
+}
+
+void StagingDatabase::Discard()
+{
+    if (m_path.empty())
+        return;
+    RemoveDatabaseFiles(m_path);
+    m_path.clear();
+}
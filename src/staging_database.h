@@ -0,0 +1,58 @@
+// Import into a copy of the target database and swap it in when complete
+#pragma once
+
+#include <string>
+
+// "<target>.staging" next to the target. Create() seeds it with the target's
+// current contents so that tables the import does not write, the manifest
+// and the row hashes carry over. Publish() makes it the target: by rename
+// when nothing else has the target open, otherwise by copying it in with the
+// online backup API. Either way readers see the old or the new database,
+// never a partial import. An unpublished staging file is deleted.
+//
+// On POSIX a rename succeeds under open connections, and an idle connection
+// holds no SQLite lock that would show it. An existing target is therefore
+// only renamed over there when its readers follow the StagingReaderLock
+// convention; without "<target>.readers" it is copied in.
+class StagingDatabase
+{
+public:
+    StagingDatabase() = default;
+    ~StagingDatabase();
+
+    StagingDatabase(const StagingDatabase &) = delete;
+    StagingDatabase &operator=(const StagingDatabase &) = delete;
+
+    bool Create(const std::string &targetPath, std::string &error);
+
+    // The staging connection must be closed first. 'method' says how it went.
+    bool Publish(std::string &method, std::string &error);
+    void Discard();
+
+    const std::string &Path() const { return m_path; }
+
+private:
+    std::string m_targetPath;
+    std::string m_path;
+};
+
+// Held by a reader for as long as it keeps the target database open: a shared
+// lock on "<target>.readers", which Publish() must lock exclusively before it
+// renames over the target. A reader that waits for the lock while a publish
+// renames opens the new file afterwards. Does nothing on Windows, where the
+// rename itself fails while the target is open.
+class StagingReaderLock
+{
+public:
+    StagingReaderLock() = default;
+    ~StagingReaderLock();
+
+    StagingReaderLock(const StagingReaderLock &) = delete;
+    StagingReaderLock &operator=(const StagingReaderLock &) = delete;
+
+    bool Acquire(const std::string &targetPath, std::string &error);
+    void Release();
+
+private:
+    int m_fd = -1;
+};
@@ -0,0 +1,49 @@
+// Binds a row of a columnar RowBatch to a schema's prepared INSERT. Each
+// column's parse kind is resolved at compile time, so the column loop unrolls
+// without branching on types. Text is bound straight from the batch arena.
+#pragma once
+
+#include "csv_reader.h"
+#include "sqlite_insert.h"
+#include "table_schema.h"
+
+#include <utility>
+
+namespace detail
+{
+    template <typename Schema, size_t I>
+    bool BindColumn(PreparedInsert &insert, const RowBatch &batch, size_t row)
+    {
+        constexpr TypedDefault def = Schema::kColumns[I].value;
+        const BatchColumn &column = batch.columns[I];
+
+        if constexpr (def.type == SqlType::Text)
+            return column.IsNull(row) ? insert.BindText(I, def.text) : insert.BindText(I, batch.Text(I, row));
+        else if constexpr (def.type == SqlType::Real)
+            return insert.BindReal(I, column.IsNull(row) ? def.real : column.numbers[row].real);
+        else if (column.IsNull(row))
+            return insert.BindInteger(I, def.integer);
+        else
+            return column.IsReal(row) ? insert.BindReal(I, column.numbers[row].real)
+                                      : insert.BindInteger(I, column.numbers[row].integer);
+    }
+
+    template <typename Schema, size_t... I>
+    bool BindColumns(PreparedInsert &insert, const RowBatch &batch, size_t row, std::index_sequence<I...>)
+    {
+        return (BindColumn<Schema, I>(insert, batch, row) && ...);
+    }
+}
+
+template <typename Schema>
+constexpr size_t ColumnCount()
+{
+    return Schema::kColumns.size();
+}
+
+// Binds every column of row 'row' of a batch parsed against the same schema
+template <typename Schema>
+bool BindRow(PreparedInsert &insert, const RowBatch &batch, size_t row)
+{
+    return detail::BindColumns<Schema>(insert, batch, row, std::make_index_sequence<ColumnCount<Schema>()>());
+}
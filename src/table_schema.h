@@ -0,0 +1,359 @@
+// Compile-time descriptions of the imported tables. The DDL in CreateTables
+// and the per-column binding in the importer are both generated from these.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+enum class SqlType
+{
+    Text,
+    Real,
+    Integer
+};
+
+// Value bound when a cell is empty, in the column's own storage class
+struct TypedDefault
+{
+    SqlType type;
+    double real;
+    long long integer;
+    const char *text;
+};
+
+constexpr TypedDefault TextDefault(const char *value) { return {SqlType::Text, 0.0, 0, value}; }
+constexpr TypedDefault RealDefault(double value) { return {SqlType::Real, value, 0, nullptr}; }
+constexpr TypedDefault IntegerDefault(long long value) { return {SqlType::Integer, 0.0, value, nullptr}; }
+
+// Key columns are interned into a per-import dictionary of their domain, so
+// that the same recipe or material number maps to the same dense id in
+// every table
+enum class KeyDomain
+{
+    None,
+    Recipe,
+    Material
+};
+
+struct ColumnDesc
+{
+    const char *name;
+    const char *sqlType;     // declared type, e.g. "TEXT(6)"
+    const char *constraints; // column constraints in the DDL, may be empty
+    TypedDefault value;      // parse kind and the value bound for empty cells
+    KeyDomain key = KeyDomain::None;
+};
+
+// A key column that must name an existing row of its key domain's table
+struct ForeignKeyDesc
+{
+    size_t column; // index into the schema's kColumns
+    const char *parentTable;
+    const char *parentColumn;
+};
+
+// A secondary index on one column, built once the table is loaded when the
+// import asks for secondary indexes
+struct IndexDesc
+{
+    const char *name;
+    size_t column; // index into the schema's kColumns
+};
+
+// How the tables that allow it store their rows. A rowid table keeps each row
+// under an integer rowid and its TEXT primary key a second time in an
+// automatic index. A WITHOUT ROWID table keeps the row in the primary key's
+// own B-tree, in key order, so the key is stored once and a lookup by key is
+// one search instead of two.
+enum class TableLayout
+{
+    Rowid,
+    WithoutRowid
+};
+
+inline const char *TableLayoutName(TableLayout layout)
+{
+    return layout == TableLayout::WithoutRowid ? "without-rowid" : "rowid";
+}
+
+inline bool ParseTableLayout(std::string_view name, TableLayout &layout)
+{
+    if (name == "rowid")
+        layout = TableLayout::Rowid;
+    else if (name == "without-rowid")
+        layout = TableLayout::WithoutRowid;
+    else
+        return false;
+    return true;
+}
+
+// Materials, keyed by MatItemNr
+struct MatlistSchema
+{
+    static constexpr const char *kName = "Matlist";
+    static constexpr std::array<ColumnDesc, 19> kColumns = {{
+        {"MatItemNr",    "TEXT(6)",  "PRIMARY KEY",  TextDefault(""), KeyDomain::Material},
+        {"Name",         "TEXT(32)", "NOT NULL",     TextDefault("")},
+        {"SetPlusTol",   "REAL",     "DEFAULT 0.01", RealDefault(0.01)},
+        {"SetMinusTol",  "REAL",     "DEFAULT 0.01", RealDefault(0.01)},
+        {"ThermcapIx",   "INTEGER",  "DEFAULT -1",   IntegerDefault(-1)},
+        {"TA",           "INTEGER",  "DEFAULT -1",   IntegerDefault(-1)},
+        {"TATyp",        "INTEGER",  "DEFAULT -1",   IntegerDefault(-1)},
+        {"PriceKG",      "REAL",     "DEFAULT 0.0",  RealDefault(0.0)},
+        {"StSizeMin",    "REAL",     "DEFAULT 0.0",  RealDefault(0.0)},
+        {"StSizeAlarm",  "REAL",     "DEFAULT 0.0",  RealDefault(0.0)},
+        {"ReplaceMatNr", "TEXT(6)",  "DEFAULT ''",   TextDefault("")},
+        {"CompTyp",      "INTEGER",  "DEFAULT 0",    IntegerDefault(0)},
+        {"Variante",     "INTEGER",  "DEFAULT 1",    IntegerDefault(1)},
+        {"MatTyp",       "INTEGER",  "DEFAULT 0",    IntegerDefault(0)},
+        {"InformUser",   "INTEGER",  "DEFAULT 0",    IntegerDefault(0)},
+        {"Decremt",      "INTEGER",  "DEFAULT 1",    IntegerDefault(1)},
+        {"Allergene",    "INTEGER",  "DEFAULT 0",    IntegerDefault(0)},
+        {"Barcode",      "TEXT(30)", "DEFAULT ''",   TextDefault("")},
+        {"Gebindem",     "REAL",     "DEFAULT 0.00", RealDefault(0.00)}}};
+    static constexpr std::array<size_t, 1> kPrimaryKey = {0};
+    static constexpr int kKeyColumn = 0; // defines the Material key domain
+    static constexpr std::array<ForeignKeyDesc, 0> kForeignKeys = {};
+    static constexpr bool kWithoutRowid = true; // under TableLayout::WithoutRowid
+    static constexpr std::array<IndexDesc, 0> kIndexes = {};
+};
+
+// Recipe headers, keyed by Nr
+struct RecipeHeadSchema
+{
+    static constexpr const char *kName = "RecipeHead";
+    static constexpr std::array<ColumnDesc, 63> kColumns = {{
+        {"Nr",              "TEXT",    "PRIMARY KEY",        TextDefault(""), KeyDomain::Recipe},
+        {"Name",            "TEXT",    "NOT NULL",           TextDefault("")},
+        {"LongName",        "TEXT",    "",                   TextDefault("")},
+        {"PieceWeight",     "REAL",    "DEFAULT 1.0",        RealDefault(1.0)},
+        {"RcpWeight",       "REAL",    "",                   RealDefault(0.0)},
+        {"RunTime",         "TEXT",    "DEFAULT '00:00:00'", TextDefault("00:00:00")},
+        {"NameVariantB",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantC",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantD",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantE",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantF",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantG",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantH",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantI",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantJ",    "TEXT",    "",                   TextDefault("")},
+        {"NameVariantK",    "TEXT",    "",                   TextDefault("")},
+        {"TA",              "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_B",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_C",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_D",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_E",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_F",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_G",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_H",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_I",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_J",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"TA_K",            "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill",      "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_B",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_C",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_D",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_E",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_F",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_G",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_H",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_I",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_J",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteStill_K",    "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp",       "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_B",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_C",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_D",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_E",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_F",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_G",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_H",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_I",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_J",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"PasteTemp_K",     "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"WaterKorr",       "INTEGER", "DEFAULT 0",          IntegerDefault(0)},
+        {"MixerGroup",      "INTEGER", "DEFAULT 0",          IntegerDefault(0)},
+        {"KnetRecipe",      "INTEGER", "DEFAULT 0",          IntegerDefault(0)},
+        {"TargetLine",      "INTEGER", "DEFAULT 1",          IntegerDefault(1)},
+        {"LineWeight",      "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"Article1",        "TEXT",    "",                   TextDefault("")},
+        {"Article2",        "TEXT",    "",                   TextDefault("")},
+        {"Article3",        "TEXT",    "",                   TextDefault("")},
+        {"ShowBacktip",     "INTEGER", "DEFAULT 0",          IntegerDefault(0)},
+        {"Public",          "INTEGER", "DEFAULT 1",          IntegerDefault(1)},
+        {"RecipeGroup",     "INTEGER", "DEFAULT 0",          IntegerDefault(0)},
+        {"MinBatchWeight",  "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"OptiBatchWeight", "REAL",    "DEFAULT 0.0",        RealDefault(0.0)},
+        {"MaxBatchWeight",  "REAL",    "DEFAULT 0.0",        RealDefault(0.0)}}};
+    static constexpr std::array<size_t, 1> kPrimaryKey = {0};
+    static constexpr int kKeyColumn = 0; // defines the Recipe key domain
+    static constexpr std::array<ForeignKeyDesc, 0> kForeignKeys = {};
+    static constexpr bool kWithoutRowid = false; // 63 columns: too wide to store in the key's B-tree
+    static constexpr std::array<IndexDesc, 0> kIndexes = {};
+};
+
+// Recipe lines, keyed by (RcpNr, RcpLine)
+struct RecipeLineSchema
+{
+    static constexpr const char *kName = "RecipeLine";
+    static constexpr std::array<ColumnDesc, 29> kColumns = {{
+        {"RcpNr",          "TEXT",    "NOT NULL",     TextDefault(""), KeyDomain::Recipe},
+        {"RcpLine",        "INTEGER", "NOT NULL",     IntegerDefault(0)},
+        {"Variante",       "INTEGER", "DEFAULT 1",    IntegerDefault(1)},
+        {"MatItemNr",      "TEXT",    "NOT NULL",     TextDefault(""), KeyDomain::Material},
+        {"Dostyp",         "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"ScaleNr",        "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"SetWeight",      "REAL",    "NOT NULL",     RealDefault(0.0)},
+        {"SetPlusTol",     "REAL",    "DEFAULT 0.01", RealDefault(0.01)},
+        {"SetMinusTol",    "REAL",    "DEFAULT 0.01", RealDefault(0.01)},
+        {"Discharge",      "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"WaterTemp",      "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"Mixtime",        "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"Mixtyp",         "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"KnetInc1",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"KnetInc2",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"KnetInc3",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"KompInc1",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"KompInc2",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"KompInc3",       "REAL",    "DEFAULT 0.0",  RealDefault(0.0)},
+        {"ReplaceMatNr",   "TEXT",    "",             TextDefault("")},
+        {"CompTyp",        "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"CompVariante",   "INTEGER", "DEFAULT 1",    IntegerDefault(1)},
+        {"EnergyEntry",    "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"RecipeLineId",   "TEXT",    "NOT NULL",     TextDefault("")},
+        {"TransferToSPS",  "INTEGER", "DEFAULT 1",    IntegerDefault(1)},
+        {"KneadToolParam", "INTEGER", "",             IntegerDefault(0)},
+        {"KneadBowlParam", "INTEGER", "",             IntegerDefault(0)},
+        {"Gebinde",        "INTEGER", "DEFAULT 0",    IntegerDefault(0)},
+        {"RecipeTip",      "TEXT",    "",             TextDefault("")}}};
+    static constexpr std::array<size_t, 2> kPrimaryKey = {0, 1};
+    static constexpr int kKeyColumn = -1;
+    static constexpr std::array<ForeignKeyDesc, 2> kForeignKeys = {{
+        {0, "RecipeHead", "Nr"},
+        {3, "Matlist", "MatItemNr"}}};
+    static constexpr bool kWithoutRowid = true;
+    static constexpr std::array<IndexDesc, 1> kIndexes = {{
+        {"RecipeLine_MatItemNr", 3}}}; // where-used: the recipes that use a material
+};
+
+// Runtime view of a schema's columns, for stages that are not templates
+struct TableColumns
+{
+    const ColumnDesc *columns;
+    size_t count;
+};
+
+template <typename Schema>
+constexpr TableColumns ColumnsOf()
+{
+    return {Schema::kColumns.data(), Schema::kColumns.size()};
+}
+
+// The primary key columns as "a, b"
+template <typename Schema>
+std::string PrimaryKeyList()
+{
+    std::string list;
+    for (size_t column : Schema::kPrimaryKey)
+    {
+        if (!list.empty())
+            list += ", ";
+        list += Schema::kColumns[column].name;
+    }
+    return list;
+}
+
+// All columns in declaration order as "a, b, ..."
+template <typename Schema>
+std::string ColumnList()
+{
+    std::string list;
+    for (const ColumnDesc &column : Schema::kColumns)
+    {
+        if (!list.empty())
+            list += ", ";
+        list += column.name;
+    }
+    return list;
+}
+
+// CREATE TABLE IF NOT EXISTS statement for a schema
+template <typename Schema>
+std::string CreateTableSql(TableLayout layout = TableLayout::Rowid)
+{
+    std::string sql = "CREATE TABLE IF NOT EXISTS ";
+    sql += Schema::kName;
+    sql += " (";
+    const char *separator = "\n    ";
+    for (const ColumnDesc &column : Schema::kColumns)
+    {
+        sql += separator;
+        sql += column.name;
+        sql += ' ';
+        sql += column.sqlType;
+        if (column.constraints[0])
+        {
+            sql += ' ';
+            sql += column.constraints;
+        }
+        separator = ",\n    ";
+    }
+    for (const ForeignKeyDesc &foreignKey : Schema::kForeignKeys)
+    {
+        sql += separator;
+        sql += "FOREIGN KEY (";
+        sql += Schema::kColumns[foreignKey.column].name;
+        sql += ") REFERENCES ";
+        sql += foreignKey.parentTable;
+        sql += '(';
+        sql += foreignKey.parentColumn;
+        sql += ')';
+    }
+    // A single-column key is declared by the column's own PRIMARY KEY constraint
+    if (Schema::kPrimaryKey.size() > 1)
+    {
+        sql += separator;
+        sql += "PRIMARY KEY (";
+        sql += PrimaryKeyList<Schema>();
+        sql += ')';
+    }
+    sql += "\n)";
+    if (Schema::kWithoutRowid && layout == TableLayout::WithoutRowid)
+        sql += " WITHOUT ROWID";
+    sql += ";\n";
+    return sql;
+}
+
+// CREATE INDEX IF NOT EXISTS statements for a schema's secondary indexes
+template <typename Schema>
+std::string CreateIndexSql()
+{
+    std::string sql;
+    for (const IndexDesc &index : Schema::kIndexes)
+    {
+        sql += "CREATE INDEX IF NOT EXISTS ";
+        sql += index.name;
+        sql += " ON ";
+        sql += Schema::kName;
+        sql += " (";
+        sql += Schema::kColumns[index.column].name;
+        sql += ");\n";
+    }
+    return sql;
+}
+
+template <typename Schema>
+std::string DropIndexSql()
+{
+    std::string sql;
+    for (const IndexDesc &index : Schema::kIndexes)
+    {
+        sql += "DROP INDEX IF EXISTS ";
+        sql += index.name;
+        sql += ";\n";
+    }
+    return sql;
+}
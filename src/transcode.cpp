@@ -0,0 +1,153 @@
+#include "transcode.h"
+#include "simd_support.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    inline size_t TranscodeScalar(const unsigned char *in, size_t size, char *out)
+    {
+        char *start = out;
+        for (size_t i = 0; i < size; i++)
+        {
+            unsigned char c = in[i];
+            if (c < 0x80)
+            {
+                *out++ = static_cast<char>(c);
+            }
+            else
+            {
+                *out++ = static_cast<char>(0xC0 | (c >> 6));
+                *out++ = static_cast<char>(0x80 | (c & 0x3F));
+            }
+        }
+        return static_cast<size_t>(out - start);
+    }
+
+#ifdef BAKERY_HAS_SSE2
+    // pshufb patterns that compact 8 widened 16-bit lanes into UTF-8: for each
+    // 8-bit "high byte" mask, keep the low byte of every lane and the high
+    // byte only of lanes that hold a two-byte sequence
+    struct WidenTable
+    {
+        alignas(16) uint8_t shuffle[256][16];
+        uint8_t length[256];
+
+        constexpr WidenTable() : shuffle(), length()
+        {
+            for (int mask = 0; mask < 256; mask++)
+            {
+                int n = 0;
+                for (int lane = 0; lane < 8; lane++)
+                {
+                    shuffle[mask][n++] = static_cast<uint8_t>(lane * 2);
+                    if (mask & (1 << lane))
+                        shuffle[mask][n++] = static_cast<uint8_t>(lane * 2 + 1);
+                }
+                length[mask] = static_cast<uint8_t>(n);
+                for (; n < 16; n++)
+                    shuffle[mask][n] = 0x80;
+            }
+        }
+    };
+
+    constexpr WidenTable g_widenTable;
+
+    // Widens 8 input bytes (low half of 'bytes') and writes up to 16 bytes
+    BAKERY_TARGET_AVX2 inline size_t Widen8(__m128i bytes, unsigned mask, char *out)
+    {
+        __m128i lanes = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+        __m128i lead = _mm_or_si128(_mm_srli_epi16(lanes, 6), _mm_set1_epi16(0xC0));
+        __m128i cont = _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+        __m128i pair = _mm_or_si128(lead, _mm_slli_epi16(cont, 8));
+        __m128i isHigh = _mm_cmpgt_epi16(lanes, _mm_set1_epi16(0x7F));
+        __m128i words = _mm_or_si128(_mm_and_si128(isHigh, pair), _mm_andnot_si128(isHigh, lanes));
+
+        __m128i pattern = _mm_load_si128(reinterpret_cast<const __m128i *>(g_widenTable.shuffle[mask]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(words, pattern));
+        return g_widenTable.length[mask];
+    }
+
+    BAKERY_TARGET_AVX2 size_t TranscodeAvx2(const unsigned char *in, size_t size, char *out)
+    {
+        char *start = out;
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + pos));
+            uint32_t high = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+            if (high == 0)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), chunk);
+                out += 32;
+                continue;
+            }
+
+            // Each Widen8 writes 16 bytes but advances by at most that, and
+            // output never runs ahead of twice the consumed input
+            __m128i lo = _mm256_castsi256_si128(chunk);
+            __m128i hi = _mm256_extracti128_si256(chunk, 1);
+            out += Widen8(lo, high & 0xFF, out);
+            out += Widen8(_mm_srli_si128(lo, 8), (high >> 8) & 0xFF, out);
+            out += Widen8(hi, (high >> 16) & 0xFF, out);
+            out += Widen8(_mm_srli_si128(hi, 8), high >> 24, out);
+        }
+        out += TranscodeScalar(in + pos, size - pos, out);
+        return static_cast<size_t>(out - start);
+    }
+
+    size_t TranscodeSse2(const unsigned char *in, size_t size, char *out)
+    {
+        char *start = out;
+        size_t pos = 0;
+        while (pos + 32 <= size)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + pos + 16));
+            if (_mm_movemask_epi8(_mm_or_si128(a, b)) == 0)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), b);
+                out += 32;
+            }
+            else
+            {
+                // No pshufb in baseline SSE2; widen this run byte by byte
+                out += TranscodeScalar(in + pos, 32, out);
+            }
+            pos += 32;
+        }
+        out += TranscodeScalar(in + pos, size - pos, out);
+        return static_cast<size_t>(out - start);
+    }
+#endif
+}
+
+size_t TranscodeLatin1ToUtf8(const char *in, size_t size, char *out)
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return TranscodeLatin1ToUtf8(in, size, out, level);
+}
+
+size_t TranscodeLatin1ToUtf8(const char *in, size_t size, char *out, SimdLevel level)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(in);
+#ifdef BAKERY_HAS_SSE2
+    // Never run a kernel the CPU cannot execute
+    if (level == SimdLevel::Avx2 && DetectSimdLevel() == SimdLevel::Avx2)
+        return TranscodeAvx2(bytes, size, out);
+    if (level != SimdLevel::Scalar)
+        return TranscodeSse2(bytes, size, out);
+#else
+    (void)level;
+#endif
+    return TranscodeScalar(bytes, size, out);
+}
+
+std::string ConvertISO88591ToUTF8(std::string_view iso_string)
+{
+    std::string utf8_string(Latin1ToUtf8MaxSize(iso_string.size()), '\0');
+    utf8_string.resize(TranscodeLatin1ToUtf8(iso_string.data(), iso_string.size(), &utf8_string[0]));
+    return utf8_string;
+}
@@ -0,0 +1,26 @@
+// ISO-8859-1 to UTF-8 transcoding with an ASCII fast path
+#pragma once
+
+#include "simd_support.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Worst case output size: every byte >= 0x80 widens to two
+inline size_t Latin1ToUtf8MaxSize(size_t size)
+{
+    return size * 2;
+}
+
+// Transcodes 'size' bytes into 'out', which must hold Latin1ToUtf8MaxSize(size)
+// bytes. Returns the number of bytes written. Pure ASCII runs are bulk-copied
+// 32 bytes at a time; only runs with high bytes are widened.
+size_t TranscodeLatin1ToUtf8(const char *in, size_t size, char *out);
+
+// Same, with the kernel picked by the caller instead of DetectSimdLevel(), for
+// tests and benchmarks. Levels above DetectSimdLevel() fall back to it.
+size_t TranscodeLatin1ToUtf8(const char *in, size_t size, char *out, SimdLevel level);
+
+// Convenience wrapper returning a new string
+std::string ConvertISO88591ToUTF8(std::string_view iso_string);
@@ -0,0 +1,181 @@
+// Delta imports after a full import: rows removed from the CSV files must be
+// deleted and unchanged rows must not be rewritten, although a full import
+// leaves no row hashes behind. Exits non-zero on a failed check.
+
+#include "importer.h"
+#include "log_sink.h"
+
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int g_failures = 0;
+
+    void Check(bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            g_failures++;
+            std::printf("FAIL %s\n", what.c_str());
+        }
+    }
+
+    // Materials M0.., recipes R0.. with five lines each; 'skip' leaves keys out
+    void WriteCsv(const fs::path &folder, size_t materials, size_t recipes, const std::vector<std::string> &skip,
+                  const std::string &changedLine = "")
+    {
+        auto skipped = [&](const std::string &key) {
+            for (const std::string &s : skip)
+            {
+                if (s == key)
+                    return true;
+            }
+            return false;
+        };
+
+        std::ofstream matlist(folder / "Matlist.csv", std::ios::binary);
+        for (size_t i = 0; i < materials; i++)
+        {
+            std::string key = "M" + std::to_string(i);
+            if (!skipped(key))
+                matlist << key << ";Material " << i << ";0,5;0,25\r\n";
+        }
+
+        std::ofstream recipeHead(folder / "Recipehead.csv", std::ios::binary);
+        std::ofstream recipeLine(folder / "Recipeline.csv", std::ios::binary);
+        for (size_t i = 0; i < recipes; i++)
+        {
+            std::string key = "R" + std::to_string(i);
+            if (skipped(key))
+                continue;
+            recipeHead << key << ";Recipe " << i << ";\xC4pfel\r\n";
+            for (size_t line = 1; line <= 5; line++)
+            {
+                std::string lineKey = key + "/" + std::to_string(line);
+                std::string weight = lineKey == changedLine ? "99,5" : std::to_string(line) + ",25";
+                recipeLine << key << ';' << line << ";1;M" << (i * 5 + line) % materials << ";0;0;" << weight
+                           << "\r\n";
+            }
+        }
+    }
+
+    const TableReport *FindTable(const ImportReport &report, const std::string &table)
+    {
+        for (const TableReport &t : report.tables)
+        {
+            if (t.table == table)
+                return &t;
+        }
+        return nullptr;
+    }
+
+    bool Import(const fs::path &folder, const fs::path &db, ImportMode mode, ImportReport &report)
+    {
+        ImportOptions options;
+        options.csvFolder = folder.string();
+        options.dbPath = db.string();
+        options.mode = mode;
+        options.forceImport = true;
+        options.parseThreads = 1;
+        options.foreignKeys = ForeignKeyMode::Off;
+        ImportProgress progress;
+        report = ImportReport();
+        return RunImport(options, progress, report);
+    }
+
+    long long CountRows(const fs::path &db, const char *table)
+    {
+        sqlite3 *conn = nullptr;
+        sqlite3_stmt *stmt = nullptr;
+        long long count = -1;
+        std::string sql = std::string("SELECT COUNT(*) FROM ") + table;
+        if (sqlite3_open(db.string().c_str(), &conn) == SQLITE_OK &&
+            sqlite3_prepare_v2(conn, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW)
+            count = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+        sqlite3_close(conn);
+        return count;
+    }
+
+    void CheckCounts(const ImportReport &report, const char *table, const DeltaCounts &expected, const char *step)
+    {
+        const TableReport *t = FindTable(report, table);
+        Check(t != nullptr, std::string(step) + ": no report for " + table);
+        if (!t)
+            return;
+        const DeltaCounts &got = t->delta;
+        Check(got.inserted == expected.inserted && got.changed == expected.changed &&
+                  got.deleted == expected.deleted && got.unchanged == expected.unchanged,
+              std::string(step) + ": " + table + " reported " + std::to_string(got.inserted) + " inserted, " +
+                  std::to_string(got.changed) + " changed, " + std::to_string(got.deleted) + " deleted, " +
+                  std::to_string(got.unchanged) + " unchanged; expected " + std::to_string(expected.inserted) +
+                  "/" + std::to_string(expected.changed) + "/" + std::to_string(expected.deleted) + "/" +
+                  std::to_string(expected.unchanged));
+    }
+
+    DeltaCounts Counts(size_t inserted, size_t changed, size_t deleted, size_t unchanged)
+    {
+        DeltaCounts counts;
+        counts.inserted = inserted;
+        counts.changed = changed;
+        counts.deleted = deleted;
+        counts.unchanged = unchanged;
+        return counts;
+    }
+}
+
+int main()
+{
+    fs::path folder = fs::temp_directory_path() / "bakery_delta_import_test";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+    fs::path db = folder / "test.db";
+
+    ImportReport report;
+    WriteCsv(folder, 200, 20, {});
+    Check(Import(folder, db, ImportMode::Full, report), "full import");
+
+    // Full import, remove rows, then delta
+    WriteCsv(folder, 200, 20, {"M190", "M191", "M192", "R3"}, "R7/2");
+    Check(Import(folder, db, ImportMode::Delta, report), "first delta import");
+    CheckCounts(report, "Matlist", Counts(0, 0, 3, 197), "first delta");
+    CheckCounts(report, "RecipeHead", Counts(0, 0, 1, 19), "first delta");
+    CheckCounts(report, "RecipeLine", Counts(0, 1, 5, 94), "first delta");
+    Check(CountRows(db, "Matlist") == 197, "Matlist rows after the first delta");
+    Check(CountRows(db, "RecipeHead") == 19, "RecipeHead rows after the first delta");
+    Check(CountRows(db, "RecipeLine") == 95, "RecipeLine rows after the first delta");
+
+    // Nothing changed since: nothing is written
+    Check(Import(folder, db, ImportMode::Delta, report), "second delta import");
+    CheckCounts(report, "Matlist", Counts(0, 0, 0, 197), "second delta");
+    CheckCounts(report, "RecipeLine", Counts(0, 0, 0, 95), "second delta");
+
+    // Another full import clears the hashes; the next delta still sees removals and additions
+    Check(Import(folder, db, ImportMode::Full, report), "second full import");
+    WriteCsv(folder, 201, 20, {"M190", "M191", "M192", "M5", "R3"}, "R7/2");
+    Check(Import(folder, db, ImportMode::Delta, report), "delta after the second full import");
+    CheckCounts(report, "Matlist", Counts(1, 0, 1, 196), "delta after full");
+    Check(CountRows(db, "Matlist") == 197, "Matlist rows after the last delta");
+
+    std::vector<LogRecord> log;
+    AppLog().Drain(log);
+    if (g_failures)
+    {
+        for (const LogRecord &record : log)
+            std::printf("  %s\n", record.text.c_str());
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    fs::remove_all(folder);
+    std::printf("All delta import checks passed\n");
+    return EXIT_SUCCESS;
+}
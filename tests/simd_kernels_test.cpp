@@ -0,0 +1,447 @@
+// Checks every SIMD kernel (transcoder, tokenizer and the CsvScanner built on
+// it) against an independent reference and the scalar kernel, and the scanner
+// against the original getline splitter. Exits non-zero on a mismatch;
+// kernels the CPU cannot run are skipped.
+
+#include "csv_scanner.h"
+#include "csv_tokenizer.h"
+#include "simd_support.h"
+#include "transcode.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void Fail(const char *test, const char *kernel, const std::string &detail)
+    {
+        if (g_failures++ < 20)
+            std::printf("FAIL %s [%s]: %s\n", test, kernel, detail.c_str());
+    }
+
+    const char *LevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::Avx2:
+            return "AVX2";
+        case SimdLevel::Sse2:
+            return "SSE2";
+        default:
+            return "scalar";
+        }
+    }
+
+    std::vector<SimdLevel> SupportedLevels()
+    {
+        std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+        if (DetectSimdLevel() != SimdLevel::Scalar)
+            levels.push_back(SimdLevel::Sse2);
+        if (DetectSimdLevel() == SimdLevel::Avx2)
+            levels.push_back(SimdLevel::Avx2);
+        return levels;
+    }
+
+    // Independent reference: one or two bytes per input byte
+    std::string ReferenceUtf8(const std::string &latin1)
+    {
+        std::string out;
+        for (unsigned char c : latin1)
+        {
+            if (c < 0x80)
+            {
+                out += static_cast<char>(c);
+            }
+            else
+            {
+                out += static_cast<char>(0xC0 | (c >> 6));
+                out += static_cast<char>(0x80 | (c & 0x3F));
+            }
+        }
+        return out;
+    }
+
+    // Transcodes into a buffer of exactly Latin1ToUtf8MaxSize() bytes followed
+    // by a guard area, so writes past the documented size are caught
+    void CheckTranscode(const std::string &input, SimdLevel level, const char *what)
+    {
+        constexpr size_t kGuard = 64;
+        const size_t capacity = Latin1ToUtf8MaxSize(input.size());
+        std::vector<char> buffer(capacity + kGuard, '\x5A');
+
+        size_t written = TranscodeLatin1ToUtf8(input.data(), input.size(), buffer.data(), level);
+        std::string expected = ReferenceUtf8(input);
+        if (written != expected.size())
+        {
+            Fail("transcode", LevelName(level),
+                 std::string(what) + ", " + std::to_string(input.size()) + " input bytes, wrote " +
+                     std::to_string(written) + " instead of " + std::to_string(expected.size()));
+            return;
+        }
+        for (size_t i = 0; i < written; i++)
+        {
+            if (buffer[i] != expected[i])
+            {
+                Fail("transcode", LevelName(level),
+                     std::string(what) + ", " + std::to_string(input.size()) + " input bytes, output differs at " +
+                         std::to_string(i));
+                return;
+            }
+        }
+        for (size_t i = capacity; i < buffer.size(); i++)
+        {
+            if (buffer[i] != '\x5A')
+            {
+                Fail("transcode", LevelName(level),
+                     std::string(what) + ", wrote past the output size at +" + std::to_string(i - capacity));
+                return;
+            }
+        }
+    }
+
+    void TestTranscode()
+    {
+        std::mt19937 random(20240611);
+        for (SimdLevel level : SupportedLevels())
+        {
+            // Every byte value, alone and at every position of runs that span
+            // the 16 and 32 byte blocks, among ASCII and among high bytes
+            for (int value = 0; value < 256; value++)
+            {
+                char c = static_cast<char>(value);
+                CheckTranscode(std::string(1, c), level, "single byte");
+                CheckTranscode(std::string(67, c), level, "repeated byte");
+                for (size_t length : {15, 16, 17, 31, 32, 33, 64, 70})
+                {
+                    for (size_t pos = 0; pos < length; pos++)
+                    {
+                        std::string ascii(length, 'a');
+                        ascii[pos] = c;
+                        CheckTranscode(ascii, level, "byte among ASCII");
+                        std::string high(length, '\xE4');
+                        high[pos] = c;
+                        CheckTranscode(high, level, "byte among high bytes");
+                    }
+                }
+            }
+
+            std::string all;
+            for (int value = 0; value < 256; value++)
+                all += static_cast<char>(value);
+            for (size_t offset = 0; offset < 40; offset++)
+                CheckTranscode(all.substr(offset) + all.substr(0, offset), level, "all bytes rotated");
+
+            // Random text with varying shares of high bytes
+            for (int round = 0; round < 2000; round++)
+            {
+                size_t length = random() % 300;
+                unsigned highPercent = random() % 101;
+                std::string text(length, '\0');
+                for (char &c : text)
+                    c = static_cast<char>(random() % 100 < highPercent ? 0x80 + random() % 128 : random() % 128);
+                CheckTranscode(text, level, "random text");
+            }
+        }
+    }
+
+    // Independent reference: one token per ';' or '\n', flags of the bytes since the last one
+    uint8_t ReferenceTokens(const std::string &text, std::vector<CsvToken> &tokens)
+    {
+        uint8_t flags = 0;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c == ';' || c == '\n')
+            {
+                if (c == '\n')
+                    flags |= FieldEndsLine;
+                tokens.push_back({static_cast<uint32_t>(i), flags});
+                flags = 0;
+            }
+            else if (c == ',')
+                flags |= FieldHasComma;
+            else if (c == '"')
+                flags |= FieldHasQuote;
+            else if (c == '\r')
+                flags |= FieldHasCarriageReturn;
+            else if (c >= 0x80)
+                flags |= FieldHasHighBytes;
+        }
+        return flags;
+    }
+
+    std::vector<CsvTokenizerKernel> SupportedKernels()
+    {
+        std::vector<CsvTokenizerKernel> kernels = {CsvTokenizerKernel::Scalar};
+        if (DetectTokenizerKernel() != CsvTokenizerKernel::Scalar)
+            kernels.push_back(CsvTokenizerKernel::Sse2);
+        if (DetectTokenizerKernel() == CsvTokenizerKernel::Avx2)
+            kernels.push_back(CsvTokenizerKernel::Avx2);
+        return kernels;
+    }
+
+    // Runs every kernel on 'text' at a few misalignments and compares the
+    // tokens and trailing flags with the reference and with the scalar kernel
+    void CheckTokenize(const std::string &text, const char *what)
+    {
+        std::vector<CsvToken> expected;
+        uint8_t expectedPending = ReferenceTokens(text, expected);
+
+        std::vector<CsvToken> scalar;
+        uint8_t scalarPending = TokenizeBlock(text.data(), text.size(), scalar, CsvTokenizerKernel::Scalar);
+
+        for (CsvTokenizerKernel kernel : SupportedKernels())
+        {
+            for (size_t misalign = 0; misalign < 4; misalign++)
+            {
+                std::string shifted = std::string(misalign, 'x') + text;
+                std::vector<CsvToken> tokens;
+                uint8_t pending = TokenizeBlock(shifted.data() + misalign, text.size(), tokens, kernel);
+
+                const std::vector<CsvToken> &reference = kernel == CsvTokenizerKernel::Scalar ? expected : scalar;
+                uint8_t referencePending = kernel == CsvTokenizerKernel::Scalar ? expectedPending : scalarPending;
+                std::string detail = std::string(what) + ", " + std::to_string(text.size()) + " bytes, misaligned by " +
+                                     std::to_string(misalign);
+                if (tokens.size() != reference.size())
+                {
+                    Fail("tokenize", TokenizerKernelName(kernel),
+                         detail + ": " + std::to_string(tokens.size()) + " tokens instead of " +
+                             std::to_string(reference.size()));
+                    return;
+                }
+                for (size_t i = 0; i < tokens.size(); i++)
+                {
+                    if (tokens[i].offset != reference[i].offset || tokens[i].flags != reference[i].flags)
+                    {
+                        Fail("tokenize", TokenizerKernelName(kernel),
+                             detail + ": token " + std::to_string(i) + " is " + std::to_string(tokens[i].offset) + "/" +
+                                 std::to_string(tokens[i].flags) + " instead of " +
+                                 std::to_string(reference[i].offset) + "/" + std::to_string(reference[i].flags));
+                        return;
+                    }
+                }
+                if (pending != referencePending)
+                {
+                    Fail("tokenize", TokenizerKernelName(kernel),
+                         detail + ": trailing flags " + std::to_string(pending) + " instead of " +
+                             std::to_string(referencePending));
+                    return;
+                }
+            }
+        }
+    }
+
+    void TestTokenize()
+    {
+        const char interesting[] = {';', '\n', '\r', '"', ',', '\xE4', '\x80', '\xFF', 'a', '0'};
+        const size_t lengths[] = {1, 15, 16, 17, 31, 32, 33, 47, 48, 63, 64, 65, 95, 96, 97, 127, 128, 129, 200};
+
+        CheckTokenize("", "empty block");
+
+        // One special byte at every position, in plain and in busy fields
+        for (char c : interesting)
+        {
+            for (size_t length : lengths)
+            {
+                for (size_t pos = 0; pos < length; pos++)
+                {
+                    std::string plain(length, 'a');
+                    plain[pos] = c;
+                    CheckTokenize(plain, "byte among plain text");
+                    std::string busy(length, '\0');
+                    for (size_t i = 0; i < length; i++)
+                        busy[i] = "a,\"\xE4"[i % 4];
+                    busy[pos] = c;
+                    CheckTokenize(busy, "byte among flagged text");
+                }
+            }
+        }
+
+        // CRLF, ";;" and quoted fields straddling each 16 and 32 byte boundary
+        const char *straddlers[] = {"\r\n", ";;", "\";\"", "\"\"", ";\r\n", "\xE4;", ",\n", "\";\r\n\""};
+        for (const char *straddler : straddlers)
+        {
+            std::string piece = straddler;
+            for (size_t boundary = 16; boundary <= 192; boundary += 16)
+            {
+                for (size_t before = 1; before < piece.size() + 1 && before <= boundary; before++)
+                {
+                    std::string text(boundary - before, 'b');
+                    text += piece;
+                    text += std::string(boundary % 64 + 7, 'c');
+                    CheckTokenize(text, "sequence across a block boundary");
+                }
+            }
+        }
+
+        // Records shaped like the exports, with CRLF line ends
+        std::string lines;
+        for (int row = 0; row < 200; row++)
+            lines += "12" + std::to_string(row) + ";\"M\xFCsli " + std::to_string(row) + "\";0,25;;kg\r\n";
+        for (size_t length = 0; length <= 300; length++)
+            CheckTokenize(lines.substr(0, length), "CRLF records");
+        CheckTokenize(lines, "CRLF records");
+
+        // Random text drawn mostly from the special bytes
+        std::mt19937 random(1234567);
+        for (int round = 0; round < 20000; round++)
+        {
+            size_t length = random() % 260;
+            std::string text(length, '\0');
+            for (char &c : text)
+                c = random() % 4 == 0 ? static_cast<char>(random() % 256) : interesting[random() % sizeof(interesting)];
+            CheckTokenize(text, "random text");
+        }
+    }
+
+    // The splitting of the original ReadCSVWithEncoding, without its transcoding
+    // and decimal comma handling (those stages are tested on their own)
+    std::vector<std::vector<std::string>> GetlineRows(const std::string &text)
+    {
+        std::vector<std::vector<std::string>> data;
+        std::istringstream file(text);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::stringstream ss(line);
+            std::string cell;
+            std::vector<std::string> row;
+
+            while (std::getline(ss, cell, ';'))
+            {
+                cell.erase(0, cell.find_first_not_of(" \t\r\n"));
+                cell.erase(cell.find_last_not_of(" \t\r\n") + 1);
+                row.push_back(cell);
+            }
+
+            if (!row.empty())
+                data.push_back(row);
+        }
+        return data;
+    }
+
+    // Rows of 'text' as CsvScanner splits them with 'kernel'
+    std::vector<std::vector<std::string>> ScannerRows(const std::string &text, CsvTokenizerKernel kernel)
+    {
+        CsvTokenizerKernel previous = ActiveTokenizerKernel();
+        SetActiveTokenizerKernel(kernel);
+        CsvScanner scanner(text);
+        SetActiveTokenizerKernel(previous);
+
+        std::vector<std::vector<std::string>> data;
+        std::vector<CsvField> fields;
+        while (scanner.NextRow(fields))
+        {
+            std::vector<std::string> row;
+            for (const CsvField &field : fields)
+                row.emplace_back(field.text);
+            data.push_back(row);
+        }
+        return data;
+    }
+
+    std::string Printable(const std::vector<std::string> &row)
+    {
+        std::string out;
+        for (const std::string &field : row)
+        {
+            out += out.empty() ? "[" : "|";
+            out += field.size() > 40 ? field.substr(0, 40) + "..." : field;
+        }
+        return out + "]";
+    }
+
+    void CheckScanner(const std::string &text, const char *what)
+    {
+        std::vector<std::vector<std::string>> expected = GetlineRows(text);
+        for (CsvTokenizerKernel kernel : SupportedKernels())
+        {
+            std::vector<std::vector<std::string>> rows = ScannerRows(text, kernel);
+            std::string detail = std::string(what) + ", " + std::to_string(text.size()) + " bytes";
+            size_t common = rows.size() < expected.size() ? rows.size() : expected.size();
+            size_t i = 0;
+            while (i < common && rows[i] == expected[i])
+                i++;
+            if (i < common)
+            {
+                Fail("scanner", TokenizerKernelName(kernel),
+                     detail + ": row " + std::to_string(i) + " is " + Printable(rows[i]) + " instead of " +
+                         Printable(expected[i]));
+                return;
+            }
+            if (rows.size() != expected.size())
+            {
+                Fail("scanner", TokenizerKernelName(kernel),
+                     detail + ": " + std::to_string(rows.size()) + " rows instead of " +
+                         std::to_string(expected.size()));
+                return;
+            }
+        }
+    }
+
+    // Random lines whose fields mix plain bytes with those the splitter treats specially
+    std::string RandomLines(std::mt19937 &random, size_t bytes, size_t maxFieldLength)
+    {
+        const char *pieces[] = {"a", "7", ",", " ", "\t", "\r", "\"", "\xE4", ";", ";", ";", "\n", "\r\n"};
+        std::string text;
+        while (text.size() < bytes)
+        {
+            size_t length = random() % (maxFieldLength + 1);
+            for (size_t i = 0; i < length; i++)
+                text += random() % 3 ? 'x' : *pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+            text += random() % 4 ? ";" : (random() % 2 ? "\n" : "\r\n");
+        }
+        return text;
+    }
+
+    void TestScanner()
+    {
+        // Trailing ';', blank, CR-only and whitespace-only lines, trimming, no final newline
+        const char *cases[] = {"", "\n", "\n\n\n", "\r", "\r\n", "\r\n\r\n", " ", " \t \r\n", "a", "a;", "a;\n",
+                               ";", ";\n", ";;", ";;\n", "a;;b;;\r\n", " a ; b \r\n c\t;\t\n", "a\n\nb",
+                               "a\r\n\r\nb\r\n", "a;b\r", "a\r\r\n", "\r;\r\n", "x;\n;\n;;\n", "last;line;"};
+        for (const char *text : cases)
+            CheckScanner(text, "edge case");
+
+        std::mt19937 random(7654321);
+        for (int round = 0; round < 3000; round++)
+            CheckScanner(RandomLines(random, random() % 400, 12), "random lines");
+
+        // Rows across the 256 KiB scan blocks, with and without a final newline
+        for (int round = 0; round < 4; round++)
+        {
+            std::string text = RandomLines(random, 700 * 1024, 300);
+            CheckScanner(text, "rows across scan blocks");
+            CheckScanner(text.substr(0, text.size() - 1), "rows across scan blocks, no final newline");
+        }
+
+        // A line longer than a scan block makes the block grow, in the middle and at the end
+        std::string longField(600 * 1024, 'L');
+        std::string head = RandomLines(random, 100 * 1024, 50);
+        CheckScanner(head + "a;" + longField + ";b\r\n" + RandomLines(random, 300 * 1024, 50), "long line");
+        CheckScanner(head + longField + " ;", "long last line without newline");
+        CheckScanner(longField + std::string(300 * 1024, ';') + "\n", "long line of separators");
+    }
+}
+
+int main()
+{
+    std::printf("CPU SIMD level: %s\n", LevelName(DetectSimdLevel()));
+    TestTranscode();
+    TestTokenize();
+    TestScanner();
+
+    if (g_failures)
+    {
+        std::printf("%d check(s) failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("All SIMD kernel checks passed\n");
+    return EXIT_SUCCESS;
+}